@@ -0,0 +1,114 @@
+// AssetIndex merges x, x.gz and x.br into one entry while reading every
+// stored file once, and a directory refresh drops what is gone.
+#include "check.h"
+#include "AssetIndex.h"
+#include <dlfcn.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string>
+
+namespace {
+
+int opens = 0;
+
+void writeFile(const std::string& path, const std::string& data)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+uint32_t fnv(const std::string& data)
+{
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : data)
+        hash = (hash ^ c) * 16777619u;
+    return hash;
+}
+
+/// A stand-in gzip member: header, body, then CRC and ISIZE = `plainSize`.
+std::string fakeGzip(uint32_t plainSize)
+{
+    std::string gz("\x1f\x8b\x08\0\0\0\0\0\0\x03" "compressed", 20);
+    gz.append(4, '\0');
+    for (int i = 0; i < 4; i++)
+        gz.push_back((char)(plainSize >> (8 * i)));
+    return gz;
+}
+
+}  // namespace
+
+// Counts the index's file reads
+extern "C" int open(const char* path, int flags, ...)
+{
+    using OpenFn = int (*)(const char*, int, ...);
+    static OpenFn real = (OpenFn)dlsym(RTLD_NEXT, "open");
+    opens++;
+    va_list args;
+    va_start(args, flags);
+    int mode = va_arg(args, int);
+    va_end(args);
+    return real(path, flags, mode);
+}
+
+int main()
+{
+    char root[] = "/tmp/asset_index_XXXXXX";
+    CHECK(mkdtemp(root) != nullptr);
+    std::string base = root;
+    mkdir((base + "/assets").c_str(), 0755);
+
+    std::string js = "console.log('firefly');";
+    std::string jsGz = fakeGzip((uint32_t)js.size());
+    writeFile(base + "/assets/app.js", js);
+    writeFile(base + "/assets/app.js.gz", jsGz);
+    writeFile(base + "/assets/app.js.br", "brotli");
+    writeFile(base + "/assets/style.css.gz", fakeGzip(4321));
+    writeFile(base + "/index.html", "<html></html>");
+
+    CachePolicy policy;
+    AssetIndex index(root, policy);
+    opens = 0;
+    index.Build();
+    CHECK_EQ(index.Count(), 3u);
+    CHECK_EQ(opens, 5); // one read per stored file
+
+    AssetIndex::Entry e;
+    CHECK(index.Find("/assets/app.js?v=1", e));
+    CHECK_EQ(e.stored, 0b111);
+    CHECK_EQ(e.Get(ContentEncoding::Identity).size, js.size());
+    CHECK_EQ(e.Get(ContentEncoding::Identity).hash, fnv(js));
+    CHECK_EQ(e.Get(ContentEncoding::Gzip).hash, fnv(jsGz));
+    CHECK_EQ(e.Get(ContentEncoding::Brotli).size, 6u);
+    CHECK_EQ(e.identitySize, js.size());
+    CHECK_STR(e.mime, "application/javascript");
+
+    // Only compressed: the plain size comes from the gzip trailer
+    CHECK(index.Find("/assets/style.css", e));
+    CHECK_EQ(e.stored, 1u << (size_t)ContentEncoding::Gzip);
+    CHECK_EQ(e.identitySize, 4321u);
+
+    // A directory refresh drops removed variants and files
+    unlink((base + "/assets/app.js").c_str());
+    unlink((base + "/assets/style.css.gz").c_str());
+    opens = 0;
+    index.Refresh((base + "/assets").c_str());
+    CHECK_EQ(opens, 2);
+    CHECK(index.Find("/assets/app.js", e));
+    CHECK_EQ(e.stored, 0b110);
+    CHECK_EQ(e.identitySize, js.size());
+    CHECK(!index.Find("/assets/style.css", e));
+    CHECK(index.Find("/index.html", e));
+    CHECK_EQ(index.Count(), 2u);
+
+    // A single changed file is reloaded on its own
+    writeFile(base + "/assets/app.js", js + "//");
+    index.Refresh("/assets/app.js");
+    CHECK(index.Find("/assets/app.js", e));
+    CHECK_EQ(e.stored, 0b111);
+    CHECK_EQ(e.identitySize, js.size() + 2);
+
+    std::string cleanup = "rm -rf " + base;
+    CHECK_EQ(system(cleanup.c_str()), 0);
+    return TestResult("asset_index_test");
+}
@@ -0,0 +1,60 @@
+// Range header parsing: valid forms, clipping, and malformed headers that
+// must be ignored (full 200 response) rather than half-parsed.
+#include "check.h"
+#include "ByteRanges.h"
+
+namespace {
+
+using Result = ByteRanges::Result;
+
+Result parse(const char* header, uint32_t size = 100)
+{
+    ByteRanges r;
+    return r.Parse(header, size);
+}
+
+}  // namespace
+
+int main()
+{
+    ByteRanges r;
+    CHECK(r.Parse("bytes=5-9", 100) == Result::Ok);
+    CHECK(r.count == 1 && r.ranges[0].first == 5 && r.ranges[0].last == 9);
+
+    CHECK(r.Parse("bytes=90-", 100) == Result::Ok);
+    CHECK(r.ranges[0].first == 90 && r.ranges[0].last == 99);
+
+    CHECK(r.Parse("bytes=-10", 100) == Result::Ok);
+    CHECK(r.ranges[0].first == 90 && r.ranges[0].last == 99);
+
+    CHECK(r.Parse("bytes=-500", 100) == Result::Ok); // whole body
+    CHECK(r.ranges[0].first == 0 && r.ranges[0].last == 99);
+
+    CHECK(r.Parse("bytes=50-1000", 100) == Result::Ok); // clipped
+    CHECK(r.ranges[0].last == 99);
+
+    CHECK(r.Parse("bytes=0-0, 10-19 ,-5", 100) == Result::Ok);
+    CHECK(r.count == 3 && r.ranges[1].first == 10 && r.ranges[2].first == 95);
+
+    CHECK(r.Parse("bytes=99999999999999999999999-", 100) == Result::Unsatisfiable);
+    CHECK(parse("bytes=100-") == Result::Unsatisfiable);
+    CHECK(parse("bytes=-0") == Result::Unsatisfiable);
+    CHECK(parse("bytes=200-300, 150-") == Result::Unsatisfiable);
+
+    // Malformed: ignore the header entirely
+    CHECK(parse("bytes=5-x") == Result::Ignore);
+    CHECK(parse("bytes=5-9x") == Result::Ignore);
+    CHECK(parse("bytes=x-9") == Result::Ignore);
+    CHECK(parse("bytes=5") == Result::Ignore);
+    CHECK(parse("bytes=-") == Result::Ignore);
+    CHECK(parse("bytes=--5") == Result::Ignore);
+    CHECK(parse("bytes=5--9") == Result::Ignore);
+    CHECK(parse("bytes=+5-9") == Result::Ignore);
+    CHECK(parse("bytes= 5 -9") == Result::Ignore);
+    CHECK(parse("bytes=9-5") == Result::Ignore);
+    CHECK(parse("bytes=0-1;2-3") == Result::Ignore);
+    CHECK(parse("bytes=") == Result::Ignore);
+    CHECK(parse("items=0-5") == Result::Ignore);
+    CHECK(parse("bytes=0-1,2-3,4-5,6-7,8-9") == Result::Ignore); // too many
+    return TestResult("byte_ranges_test");
+}
@@ -0,0 +1,36 @@
+// Which URLs CachePolicy treats as content-hashed bundler output.
+#include "check.h"
+#include "CachePolicy.h"
+
+int main()
+{
+    // Vite/Rollup and webpack output
+    CHECK(CachePolicy::IsContentHashed("/assets/index-B3f9a1cZ.js"));
+    CHECK(CachePolicy::IsContentHashed("/assets/vendor-a_9-Kd2q.css"));
+    CHECK(CachePolicy::IsContentHashed("/assets/index-B3f9a1cZ.js.map"));
+    CHECK(CachePolicy::IsContentHashed("/assets/main.3f9a1c7b.js"));
+    CHECK(CachePolicy::IsContentHashed("/assets/main.3f9a1c7b.chunk.js"));
+    CHECK(CachePolicy::IsContentHashed("/assets/chunk.3f9a1c7b0d2e4f6a8b9c.js"));
+
+    // Outside the bundler's output directory
+    CHECK(!CachePolicy::IsContentHashed("/index-B3f9a1cZ.js"));
+    CHECK(!CachePolicy::IsContentHashed("/img/logo-B3f9a1cZ.png"));
+    CHECK(!CachePolicy::IsContentHashed("/index.html"));
+
+    // Names that only look versioned
+    CHECK(!CachePolicy::IsContentHashed("/assets/report-20240101.json"));  // date, no letter
+    CHECK(!CachePolicy::IsContentHashed("/assets/firmware-release.bin"));  // word, no digit
+    CHECK(!CachePolicy::IsContentHashed("/assets/font-awesome-v6.woff2")); // not 8 characters
+    CHECK(!CachePolicy::IsContentHashed("/assets/backup-2024-01-01.tar")); // no letter in the hash
+    CHECK(!CachePolicy::IsContentHashed("/assets/app.DEADBEEF.js"));       // webpack hashes are lower-case hex
+    CHECK(!CachePolicy::IsContentHashed("/assets/notes.map"));
+    CHECK(!CachePolicy::IsContentHashed("/assets/site.v2.min.js"));
+
+    // Rules still come first
+    CachePolicy policy;
+    policy.AddRule("/fonts/**", CachePolicy::Immutable);
+    CHECK_STR(policy.Evaluate("/fonts/a/b.woff2"), CachePolicy::Immutable);
+    CHECK_STR(policy.Evaluate("/assets/index-B3f9a1cZ.js"), CachePolicy::Immutable);
+    CHECK_STR(policy.Evaluate("/assets/report-20240101.json"), CachePolicy::Revalidate);
+    return TestResult("cache_policy_test");
+}
@@ -0,0 +1,27 @@
+#pragma once
+// Minimal assertions for the host tests: a failed CHECK reports and keeps
+// going, and the test exits non-zero at the end.
+#include <stdio.h>
+#include <string.h>
+
+inline int host_test_failures = 0;
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            host_test_failures++;                                                \
+        }                                                                        \
+    } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
+#define CHECK_STR(a, b) CHECK(strcmp((a), (b)) == 0)
+
+inline int TestResult(const char* name)
+{
+    if (host_test_failures)
+        fprintf(stderr, "%s: %d check(s) failed\n", name, host_test_failures);
+    else
+        printf("%s: ok\n", name);
+    return host_test_failures ? 1 : 0;
+}
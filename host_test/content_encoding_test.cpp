@@ -0,0 +1,58 @@
+// Accept-Encoding: a missing header takes gzip, and a coding counts as
+// refused only when the header gives it (or `*` with it unlisted) q=0.
+#include "check.h"
+#include "ContentEncoding.h"
+
+namespace {
+
+AcceptEncoding parse(const char* header)
+{
+    AcceptEncoding a;
+    a.Parse(header);
+    return a;
+}
+
+}  // namespace
+
+int main()
+{
+    // No header: gzip and identity, not brotli
+    AcceptEncoding none;
+    CHECK(none.Accepts(ContentEncoding::Gzip));
+    CHECK(none.Accepts(ContentEncoding::Identity));
+    CHECK(!none.Accepts(ContentEncoding::Brotli));
+    CHECK(!none.Refuses(ContentEncoding::Gzip));
+
+    AcceptEncoding browser = parse("gzip, deflate, br, zstd");
+    CHECK_EQ(browser.Quality(ContentEncoding::Brotli), 1000);
+    CHECK_EQ(browser.Quality(ContentEncoding::Gzip), 1000);
+    CHECK_EQ(browser.Quality(ContentEncoding::Identity), 1);
+
+    // Explicit refusals
+    AcceptEncoding q0 = parse("gzip;q=0");
+    CHECK(q0.Refuses(ContentEncoding::Gzip));
+    CHECK(!q0.Refuses(ContentEncoding::Identity));
+
+    AcceptEncoding star = parse("identity;q=1, *;q=0");
+    CHECK(star.Refuses(ContentEncoding::Gzip));
+    CHECK(star.Refuses(ContentEncoding::Brotli));
+    CHECK(!star.Refuses(ContentEncoding::Identity));
+    CHECK_EQ(star.Quality(ContentEncoding::Identity), 1000);
+
+    // Unlisted without `*` is not acceptable, but not refused either
+    AcceptEncoding identity = parse("identity");
+    CHECK(!identity.Accepts(ContentEncoding::Gzip));
+    CHECK(!identity.Refuses(ContentEncoding::Gzip));
+
+    AcceptEncoding weighted = parse("br;q=0.5, gzip;q=0.8, *;q=0.1");
+    CHECK_EQ(weighted.Quality(ContentEncoding::Brotli), 500);
+    CHECK_EQ(weighted.Quality(ContentEncoding::Gzip), 800);
+    CHECK_EQ(weighted.Quality(ContentEncoding::Identity), 100);
+    CHECK(!weighted.Refuses(ContentEncoding::Identity));
+
+    // Parsing again starts over
+    AcceptEncoding reused = parse("gzip;q=0");
+    reused.Parse("gzip");
+    CHECK(!reused.Refuses(ContentEncoding::Gzip));
+    return TestResult("content_encoding_test");
+}
@@ -0,0 +1,73 @@
+// A send callback that arrives after its frame timed out must not complete
+// the next command.
+#include "check.h"
+#include "EspNowTransmitter.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+
+std::atomic<int> sends{0};
+
+void waitForSends(int count)
+{
+    for (int i = 0; i < 200 && sends.load() < count; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    CHECK_EQ(sends.load(), count);
+}
+
+EspNowTransmitter::State waitForResult(EspNowTransmitter& tx, uint32_t id)
+{
+    EspNowTransmitter::Receipt r;
+    for (int i = 0; i < 100; i++) {
+        if (tx.GetReceipt(id, r) && r.state != EspNowTransmitter::State::Queued &&
+            r.state != EspNowTransmitter::State::InFlight)
+            return r.state;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return EspNowTransmitter::State::InFlight;
+}
+
+}  // namespace
+
+esp_err_t esp_now_send(const uint8_t*, const uint8_t*, size_t)
+{
+    sends++;
+    return ESP_OK;
+}
+
+int main()
+{
+    // Kept alive until exit: its task cannot be stopped on the host
+    EspNowTransmitter& tx = *new EspNowTransmitter();
+    tx.Start(BROADCAST_MAC);
+    espnow_message_t msg = {};
+
+    // The radio never answers the first frame in time
+    uint32_t a = tx.Submit(msg);
+    waitForSends(1);
+    CHECK(waitForResult(tx, a) == EspNowTransmitter::State::Failed);
+    CHECK_EQ(tx.GetStats().timeouts, 1u);
+
+    // Its success arrives while the second frame is in flight; the second
+    // frame's own callback reports a failure
+    uint32_t b = tx.Submit(msg);
+    waitForSends(2);
+    tx.OnSendComplete(ESP_NOW_SEND_SUCCESS);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    tx.OnSendComplete(ESP_NOW_SEND_FAIL);
+    CHECK(waitForResult(tx, b) == EspNowTransmitter::State::Failed);
+    CHECK_EQ(tx.GetStats().lateCallbacks, 1u);
+    CHECK_EQ(tx.GetStats().timeouts, 1u);
+
+    // Back in step: the next callback completes the next frame
+    uint32_t c = tx.Submit(msg);
+    waitForSends(3);
+    tx.OnSendComplete(ESP_NOW_SEND_SUCCESS);
+    CHECK(waitForResult(tx, c) == EspNowTransmitter::State::Sent);
+
+    EspNowTransmitter::Stats stats = tx.GetStats();
+    CHECK_EQ(stats.sent, 1u);
+    CHECK_EQ(stats.failed, 2u);
+    return TestResult("espnow_tx_test");
+}
@@ -0,0 +1,78 @@
+// GuestCommand in a batch, read the way PostScoreBatchEndpoint does: a bad
+// value fails its own item and the rest of the array still parses.
+#include "check.h"
+#include "BufferStream.h"
+#include "GuestCommand.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Item {
+    const char* error;
+    espnow_message_t msg;
+};
+
+/// Reads a batch body; false when the document itself is rejected.
+bool readBatch(std::string body, std::vector<Item>& items)
+{
+    BufferStream s(body.data(), body.size(), body.size());
+    JsonStreamReader json(s);
+    items.clear();
+    json.readArray([&](size_t) {
+        Item item;
+        item.error = GuestCommand::Read(json, item.msg);
+        items.push_back(item);
+    });
+    return json.finish();
+}
+
+bool is(const char* error, const char* expected)
+{
+    return error && strcmp(error, expected) == 0;
+}
+
+}  // namespace
+
+int main()
+{
+    std::vector<Item> items;
+    std::string longMac = "\"" + std::string(40, 'A') + "\"";
+    std::string body = "["
+        R"({"mac":"AA:BB:CC:DD:EE:01","score":1},)"
+        R"({"mac":)" + longMac + R"(,"score":2},)"
+        R"({"cmd":"blink","mac":"AA:BB:CC:DD:EE:02"})"
+        "]";
+    CHECK(readBatch(body, items));
+    CHECK_EQ(items.size(), 3u);
+    if (items.size() == 3) {
+        CHECK(items[0].error == nullptr);
+        CHECK_EQ(items[0].msg.value, 1);
+        CHECK(is(items[1].error, "invalid field"));
+        CHECK(items[2].error == nullptr);
+        CHECK(items[2].msg.event == ESPNOW_MESSAGE_EVENT_BLINK);
+        CHECK_EQ(items[2].msg.destinationMac[5], 0x02);
+    }
+
+    // Over-long cmd, scores outside int32 or not integers
+    body = "["
+        R"({"cmd":"a-command-name-far-too-long","mac":"AA:BB:CC:DD:EE:01"},)"
+        R"({"mac":"AA:BB:CC:DD:EE:01","score":4294967296},)"
+        R"({"mac":"AA:BB:CC:DD:EE:01","score":123456789012345678901234567890},)"
+        R"({"mac":"AA:BB:CC:DD:EE:01","score":1.5},)"
+        R"({"mac":"AA:BB:CC:DD:EE:01","score":-7})"
+        "]";
+    CHECK(readBatch(body, items));
+    CHECK_EQ(items.size(), 5u);
+    for (size_t i = 0; i < 4 && i < items.size(); i++)
+        CHECK(is(items[i].error, "invalid field"));
+    if (items.size() == 5) {
+        CHECK(items[4].error == nullptr);
+        CHECK_EQ(items[4].msg.value, -7);
+    }
+
+    // Broken JSON still rejects the whole body
+    CHECK(!readBatch(R"([{"mac":"AA:BB:CC:DD:EE:01","score":1},{"mac":"AA)", items));
+    CHECK(!readBatch(R"([{"mac":"AA:BB:CC:DD:EE:01","score":1-2}])", items));
+    return TestResult("guest_command_test");
+}
@@ -0,0 +1,147 @@
+// Parsing a score body ({"mac":..,"score":..}) with JsonStreamReader against
+// cJSON as PostScoreEndpoint used it before: parse the whole buffer into a
+// tree, look up two members, delete the tree. Reports time and heap
+// allocations per parse. The cJSON column needs cJSON sources (CJSON_DIR or
+// IDF_PATH at configure time); without them only the stream reader runs.
+//   json_reader_bench [--quick]
+#include "check.h"
+#include "BufferStream.h"
+#include "JsonStreamReader.h"
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#ifdef HOST_TEST_HAVE_CJSON
+#include "cJSON.h"
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    double nsPerParse;
+    double allocsPerParse;
+    size_t peakBytes;
+    int64_t checksum;
+};
+
+struct Body {
+    const char* name;
+    std::string text;
+};
+
+size_t allocs = 0;
+size_t peakBytes = 0;
+
+bool parseStream(std::string& body, int32_t& score, char (&mac)[18])
+{
+    BufferStream s(body.data(), body.size(), body.size());
+    JsonStreamReader json(s);
+    json.readObject([&](const char* key) {
+        if (strcmp(key, "score") == 0)
+            json.readInt(score);
+        else if (strcmp(key, "mac") == 0)
+            json.readString(mac, sizeof(mac));
+    });
+    return json.finish();
+}
+
+#ifdef HOST_TEST_HAVE_CJSON
+size_t liveBytes = 0;
+
+void* countingMalloc(size_t size)
+{
+    allocs++;
+    auto* p = static_cast<size_t*>(malloc(size + sizeof(size_t)));
+    *p = size;
+    liveBytes += size;
+    if (liveBytes > peakBytes)
+        peakBytes = liveBytes;
+    return p + 1;
+}
+
+void countingFree(void* ptr)
+{
+    if (!ptr)
+        return;
+    auto* p = static_cast<size_t*>(ptr) - 1;
+    liveBytes -= *p;
+    free(p);
+}
+
+bool parseCJson(std::string& body, int32_t& score, char (&mac)[18])
+{
+    cJSON* root = cJSON_ParseWithLength(body.data(), body.size());
+    if (!root)
+        return false;
+    cJSON* scoreItem = cJSON_GetObjectItem(root, "score");
+    cJSON* macItem = cJSON_GetObjectItem(root, "mac");
+    bool ok = cJSON_IsNumber(scoreItem) && cJSON_IsString(macItem);
+    if (ok) {
+        score = scoreItem->valueint;
+        snprintf(mac, sizeof(mac), "%s", macItem->valuestring);
+    }
+    cJSON_Delete(root);
+    return ok;
+}
+#endif
+
+template <typename PARSE>
+Result run(std::string body, uint32_t iterations, PARSE parse)
+{
+    allocs = 0;
+    peakBytes = 0;
+    int64_t checksum = 0;
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        int32_t score = 0;
+        char mac[18] = "";
+        CHECK(parse(body, score, mac));
+        checksum += score + mac[0];
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return Result{ns / iterations, (double)allocs / iterations, peakBytes, checksum};
+}
+
+void print(const char* body, const char* parser, const Result& r)
+{
+    printf("%-9s %-18s %10.0f %14.2f %11u\n", body, parser, r.nsPerParse, r.allocsPerParse, (unsigned)r.peakBytes);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+    uint32_t iterations = quick ? 2000 : 200000;
+
+#ifdef HOST_TEST_HAVE_CJSON
+    cJSON_Hooks hooks = {countingMalloc, countingFree};
+    cJSON_InitHooks(&hooks);
+#endif
+
+    // The UI's body, and the same with unrelated members the handler skips
+    std::string padding;
+    for (int i = 0; i < 8; i++)
+        padding += "\"extra" + std::to_string(i) + "\":{\"list\":[1,2,3,4],\"label\":\"guest name here\"},";
+    Body bodies[] = {
+        {"minimal", R"({"mac":"AA:BB:CC:DD:EE:01","score":42})"},
+        {"padded", "{" + padding + R"("mac":"AA:BB:CC:DD:EE:01","score":42})"},
+    };
+
+    printf("%-9s %-18s %10s %14s %11s\n", "body", "parser", "ns/parse", "allocs/parse", "peak heap");
+    for (Body& b : bodies) {
+        Result stream = run(b.text, iterations, parseStream);
+        print(b.name, "JsonStreamReader", stream);
+        CHECK_EQ(stream.allocsPerParse, 0.0);
+#ifdef HOST_TEST_HAVE_CJSON
+        Result tree = run(b.text, iterations, parseCJson);
+        print(b.name, "cJSON", tree);
+        CHECK_EQ(tree.checksum, stream.checksum);
+#endif
+    }
+#ifndef HOST_TEST_HAVE_CJSON
+    printf("(cJSON not found at configure time; set CJSON_DIR or IDF_PATH to compare)\n");
+#endif
+    return TestResult("json_reader_bench");
+}
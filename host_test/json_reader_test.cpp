@@ -0,0 +1,120 @@
+// JsonStreamReader: binding, skipping, error stickiness and integer range,
+// each document fed both whole and one byte per read().
+#include "check.h"
+#include "BufferStream.h"
+#include "JsonStreamReader.h"
+#include <string>
+
+namespace {
+
+/// Hands out one byte per read(), so every token straddles a refill.
+class ByteStream : public Stream {
+public:
+    explicit ByteStream(const std::string& text) : text(text) {}
+    size_t write(const void*, size_t) override { return 0; }
+    size_t read(void* out, size_t len) override
+    {
+        if (pos == text.size() || len == 0)
+            return 0;
+        static_cast<char*>(out)[0] = text[pos++];
+        return 1;
+    }
+    void flush() override {}
+
+private:
+    std::string text;
+    size_t pos = 0;
+};
+
+struct Score {
+    bool ok = false;
+    bool hasScore = false;
+    bool hasMac = false;
+    int32_t score = 0;
+    char mac[18] = "";
+};
+
+Score parseScore(Stream& s)
+{
+    Score r;
+    JsonStreamReader json(s);
+    json.readObject([&](const char* key) {
+        if (strcmp(key, "score") == 0)
+            r.hasScore = json.readInt(r.score);
+        else if (strcmp(key, "mac") == 0)
+            r.hasMac = json.readString(r.mac, sizeof(r.mac));
+    });
+    r.ok = json.finish();
+    return r;
+}
+
+/// Parses `text` whole and byte by byte; both must agree.
+Score parseScore(const char* text)
+{
+    std::string copy(text);
+    BufferStream whole(copy.data(), copy.size(), copy.size());
+    ByteStream bytes(text);
+    Score a = parseScore(whole);
+    Score b = parseScore(bytes);
+    CHECK_EQ(a.ok, b.ok);
+    CHECK_EQ(a.score, b.score);
+    CHECK_STR(a.mac, b.mac);
+    return a;
+}
+
+bool parseInt64(const char* text, int64_t& v)
+{
+    std::string copy(text);
+    BufferStream s(copy.data(), copy.size(), copy.size());
+    JsonStreamReader json(s);
+    return json.readInt(v) && json.finish();
+}
+
+}  // namespace
+
+int main()
+{
+    Score r = parseScore(R"({"score":5,"mac":"AA:BB:CC:DD:EE:FF"})");
+    CHECK(r.ok && r.hasScore && r.hasMac);
+    CHECK_EQ(r.score, 5);
+    CHECK_STR(r.mac, "AA:BB:CC:DD:EE:FF");
+
+    // Unread members of every type are skipped; escapes are decoded
+    r = parseScore(R"( { "x": [1, {"a":[true,false,null]}, "s\"q"], "score" : -12 , "mac":"Aé😀" } )");
+    CHECK(r.ok);
+    CHECK_EQ(r.score, -12);
+    CHECK_STR(r.mac, "A\xC3\xA9\xF0\x9F\x98\x80");
+
+    CHECK(parseScore("{}").ok);
+    CHECK(!parseScore("[]").ok);                        // readObject on an array
+    CHECK(!parseScore(R"({"score":5.5})").ok);           // not an integer
+    CHECK(!parseScore(R"({"score":5,})").ok);            // trailing comma
+    CHECK(!parseScore(R"({"score":5} x)").ok);           // trailing garbage
+    CHECK(!parseScore(R"({"score":1)").ok);              // truncated
+    CHECK(!parseScore(R"({"mac":"0123456789012345678"})").ok); // does not fit
+    CHECK(!parseScore(R"({"mac":"a)" "\n" R"("})").ok);  // raw control character
+    CHECK(!parseScore(R"({"a":[[[[[[[[[[[[[[[[[[1]]]]]]]]]]]]]]]]]]})").ok); // too deep
+
+    // Errors are sticky: a bad member fails the whole document
+    r = parseScore(R"({"score":"high","mac":"AA"})");
+    CHECK(!r.ok && !r.hasScore);
+
+    // int32 narrowing
+    CHECK(parseScore(R"({"score":2147483647})").ok);
+    CHECK(parseScore(R"({"score":-2147483648})").ok);
+    CHECK(!parseScore(R"({"score":2147483648})").ok);
+    CHECK(!parseScore(R"({"score":-2147483649})").ok);
+    CHECK(!parseScore(R"({"score":99999999999})").ok);
+
+    // int64 range: strtoll saturates out-of-range input, which must fail
+    int64_t v = 0;
+    CHECK(parseInt64("9223372036854775807", v) && v == INT64_MAX);
+    CHECK(parseInt64("-9223372036854775808", v) && v == INT64_MIN);
+    CHECK(!parseInt64("9223372036854775808", v));
+    CHECK(!parseInt64("-9223372036854775809", v));
+    CHECK(!parseInt64("99999999999999999999", v));
+    CHECK(!parseInt64("1e3", v));
+    CHECK(!parseInt64("--1", v));
+
+    return TestResult("json_reader_test");
+}
@@ -0,0 +1,153 @@
+// Static file streaming: the old loop (read 512 bytes, send them, repeat)
+// against ReadAheadStreamer, which reads the next 4 KB block on its own task
+// while the current one is sent. First checks that a stream still runs when
+// stalled clients hold every lane. Flash and network are modelled as waits
+// (per call plus per byte) so the numbers depend on overlap and call count,
+// not on the host's disk. A sequential 4 KB loop separates the effect of
+// bigger reads from the effect of overlapping them.
+//   readahead_bench [--quick]
+#include "check.h"
+#include "ReadAheadStreamer.h"
+#include <atomic>
+#include <chrono>
+#include <dlfcn.h>
+#include <functional>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Wait model for one call moving `bytes`.
+struct Cost {
+    double perCallUs;
+    double perByteUs;
+
+    void Wait(size_t bytes) const
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double, std::micro>(perCallUs + perByteUs * bytes));
+    }
+};
+
+// FATFS on SPI flash: a fixed cost per read call, then about 5 MB/s.
+// The socket: a fixed cost per send, then about 2 MB/s.
+constexpr Cost Flash{150, 0.2};
+constexpr Cost Network{100, 0.5};
+
+bool modelFlash = false;
+
+double runMs(const std::function<bool()>& fn)
+{
+    Clock::time_point start = Clock::now();
+    CHECK(fn());
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/// What FileGetEndpoint did before: one stack buffer, read then send.
+template <size_t Buffer>
+bool sequential(int fd, uint32_t length, std::string& out)
+{
+    char buf[Buffer];
+    for (uint32_t pos = 0; pos < length;) {
+        ssize_t n = pread(fd, buf, Buffer, pos);
+        if (n <= 0)
+            return false;
+        Network.Wait((size_t)n);
+        out.append(buf, (size_t)n);
+        pos += (uint32_t)n;
+    }
+    return true;
+}
+
+}  // namespace
+
+// Adds the flash model to every read, including the streamer's reader task
+extern "C" ssize_t pread(int fd, void* buf, size_t count, off_t offset)
+{
+    using PreadFn = ssize_t (*)(int, void*, size_t, off_t);
+    static PreadFn real = (PreadFn)dlsym(RTLD_NEXT, "pread");
+    ssize_t n = real(fd, buf, count, offset);
+    if (modelFlash && n > 0)
+        Flash.Wait((size_t)n);
+    return n;
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+    std::vector<uint32_t> sizes = quick ? std::vector<uint32_t>{16 * 1024, 64 * 1024}
+                                        : std::vector<uint32_t>{4 * 1024, 16 * 1024, 64 * 1024, 256 * 1024};
+    int rounds = quick ? 1 : 5;
+
+    char path[] = "/tmp/readahead_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    std::string data;
+    for (uint32_t i = 0; i < sizes.back(); i++)
+        data.push_back((char)('a' + i % 26));
+    CHECK_EQ(write(fd, data.data(), data.size()), (ssize_t)data.size());
+
+    // Kept alive until exit: its reader task cannot be stopped on the host
+    auto& streamer = *new ReadAheadStreamer<2, 4096>();
+    streamer.Start(5);
+
+    // Two clients that stop reading hold both lanes; a third file still
+    // streams, without read-ahead
+    {
+        std::atomic<bool> release{false};
+        std::atomic<int> stalled{0};
+        std::vector<std::thread> slow;
+        for (int i = 0; i < 2; i++) {
+            slow.emplace_back([&] {
+                streamer.Stream(fd, 0, 8192, [&](const char*, size_t) {
+                    stalled++;
+                    while (!release)
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    return true;
+                });
+            });
+        }
+        while (stalled < 2)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::string third;
+        CHECK(streamer.Stream(fd, 100, 5000, [&](const char* p, size_t n) {
+            third.append(p, n);
+            return true;
+        }) == ESP_OK);
+        CHECK(third == data.substr(100, 5000));
+        CHECK_EQ(streamer.GetDirectStreams(), 1u);
+        release = true;
+        for (std::thread& t : slow)
+            t.join();
+    }
+    modelFlash = true;
+
+    printf("%-8s %14s %14s %14s %9s\n", "size", "seq 512 ms", "seq 4096 ms", "read-ahead ms", "speedup");
+    for (uint32_t size : sizes) {
+        double seq512 = 0, seq4096 = 0, ahead = 0;
+        for (int r = 0; r < rounds; r++) {
+            std::string a, b, c;
+            seq512 += runMs([&] { return sequential<512>(fd, size, a); });
+            seq4096 += runMs([&] { return sequential<4096>(fd, size, b); });
+            ahead += runMs([&] {
+                return streamer.Stream(fd, 0, size, [&](const char* p, size_t n) {
+                    Network.Wait(n);
+                    c.append(p, n);
+                    return true;
+                }) == ESP_OK;
+            });
+            CHECK(a == data.substr(0, size) && b == a && c == a);
+        }
+        printf("%-8u %14.2f %14.2f %14.2f %8.2fx\n", (unsigned)size, seq512 / rounds, seq4096 / rounds,
+               ahead / rounds, seq512 / ahead);
+        CHECK(ahead < seq512);
+    }
+
+    close(fd);
+    unlink(path);
+    return TestResult("readahead_bench");
+}
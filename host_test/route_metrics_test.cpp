@@ -0,0 +1,34 @@
+// RouteMetrics: bucketing, status classes and a latency sum that outlasts
+// 32 bits of microseconds.
+#include "check.h"
+#include "RouteMetrics.h"
+
+int main()
+{
+    RouteMetrics m;
+    m.Begin();
+    CHECK_EQ(m.inFlight.load(), 1u);
+    m.End(400, 200, 10);
+    CHECK_EQ(m.inFlight.load(), 0u);
+    CHECK_EQ(m.buckets[0].load(), 1u);
+    CHECK_EQ(m.status[2].load(), 1u);
+
+    m.Begin();
+    m.End(1000, 404, 0); // bounds are inclusive
+    CHECK_EQ(m.buckets[1].load(), 1u);
+    CHECK_EQ(m.status[4].load(), 1u);
+
+    m.Begin();
+    m.End(3000000, 0, 0); // past the last bound; sent nothing
+    CHECK_EQ(m.buckets[RouteMetrics::BucketCount - 1].load(), 1u);
+    CHECK_EQ(m.status[0].load(), 1u);
+
+    // Two hour-long handlers already overflow 32-bit microseconds
+    for (int i = 0; i < 2; i++) {
+        m.Begin();
+        m.End(3600000000u, 200, 0);
+    }
+    CHECK_EQ(m.latencyUsSum.Load(), 400ull + 1000 + 3000000 + 2 * 3600000000ull);
+    CHECK_EQ(m.requests.load(), 5u);
+    return TestResult("route_metrics_test");
+}
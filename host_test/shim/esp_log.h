@@ -0,0 +1,11 @@
+#pragma once
+#include <stdio.h>
+
+// Warnings and errors always print; info only with HOST_TEST_VERBOSE set.
+extern bool host_log_verbose;
+
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) (host_log_verbose ? fprintf(stderr, "I %s: " fmt "\n", tag, ##__VA_ARGS__) : 0)
+#define ESP_LOGD(tag, fmt, ...) ((void)(tag))
+#define ESP_LOGV(tag, fmt, ...) ((void)(tag))
@@ -0,0 +1,16 @@
+#pragma once
+// Host stand-in for the ESP-NOW send API. Tests define esp_now_send() and
+// call the transmitter's completion hook themselves.
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define ESP_ERR_ESPNOW_BASE (0x3000 + 100)
+#define ESP_ERR_ESPNOW_NO_MEM (ESP_ERR_ESPNOW_BASE + 3)
+
+typedef enum {
+    ESP_NOW_SEND_SUCCESS = 0,
+    ESP_NOW_SEND_FAIL,
+} esp_now_send_status_t;
+
+esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, size_t len);
@@ -0,0 +1,238 @@
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+bool host_log_verbose = getenv("HOST_TEST_VERBOSE") != nullptr;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+const Clock::time_point processStart = Clock::now();
+
+/// Runs `ready` under `lock` until it holds or `timeout` ticks pass.
+template <typename PRED>
+bool waitFor(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, TickType_t timeout, PRED ready)
+{
+    if (timeout == portMAX_DELAY)
+    {
+        cv.wait(lock, ready);
+        return true;
+    }
+    return cv.wait_for(lock, std::chrono::milliseconds(timeout), ready);
+}
+
+}  // namespace
+
+struct HostSemaphore
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    UBaseType_t count;
+    UBaseType_t max;
+    std::thread::id owner;
+    UBaseType_t depth = 0;
+
+    HostSemaphore(UBaseType_t max, UBaseType_t initial) : count(initial), max(max) {}
+};
+
+struct HostQueue
+{
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+
+    HostQueue(UBaseType_t length, UBaseType_t itemSize) : length(length), itemSize(itemSize) {}
+};
+
+int64_t esp_timer_get_time()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - processStart).count();
+}
+
+const char* esp_err_to_name(esp_err_t err)
+{
+    return err == ESP_OK ? "ESP_OK" : "ESP_ERR";
+}
+
+// Tasks
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* arg, UBaseType_t priority,
+                       TaskHandle_t* handle)
+{
+    static std::atomic<uintptr_t> nextHandle{1};
+    std::thread(fn, arg).detach();
+    if (handle)
+        *handle = reinterpret_cast<TaskHandle_t>(nextHandle.fetch_add(1));
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core)
+{
+    return xTaskCreate(fn, name, stackDepth, arg, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t handle)
+{
+    // A task deleting itself returns from its function right after; other
+    // threads keep running until the process exits.
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+BaseType_t xPortGetCoreID()
+{
+    return 0;
+}
+
+// Semaphores and mutexes
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return new HostSemaphore(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return new HostSemaphore(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex()
+{
+    return new HostSemaphore(1, 1);  // tracked by owner and depth instead of count
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    return new HostSemaphore(max, initial);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    delete sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t timeout)
+{
+    std::unique_lock<std::mutex> lock(sem->mutex);
+    if (!waitFor(sem->cv, lock, timeout, [&] { return sem->count > 0; }))
+        return pdFALSE;
+    sem->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    std::lock_guard<std::mutex> lock(sem->mutex);
+    if (sem->count == sem->max)
+        return pdFALSE;
+    sem->count++;
+    sem->cv.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t timeout)
+{
+    std::unique_lock<std::mutex> lock(sem->mutex);
+    if (sem->depth > 0 && sem->owner == std::this_thread::get_id())
+    {
+        sem->depth++;
+        return pdTRUE;
+    }
+    if (!waitFor(sem->cv, lock, timeout, [&] { return sem->depth == 0; }))
+        return pdFALSE;
+    sem->owner = std::this_thread::get_id();
+    sem->depth = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem)
+{
+    std::lock_guard<std::mutex> lock(sem->mutex);
+    if (sem->depth == 0 || sem->owner != std::this_thread::get_id())
+        return pdFALSE;
+    if (--sem->depth == 0)
+        sem->cv.notify_one();
+    return pdTRUE;
+}
+
+// Queues
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    return new HostQueue(length, itemSize);
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t timeout)
+{
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!waitFor(queue->notFull, lock, timeout, [&] { return queue->items.size() < queue->length; }))
+        return pdFALSE;
+    const uint8_t* bytes = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    queue->notEmpty.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendToBackFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken)
+{
+    return xQueueSendToBack(queue, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t timeout)
+{
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!waitFor(queue->notEmpty, lock, timeout, [&] { return !queue->items.empty(); }))
+        return pdFALSE;
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    queue->notFull.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t timeout)
+{
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!waitFor(queue->notEmpty, lock, timeout, [&] { return !queue->items.empty(); }))
+        return pdFALSE;
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->items.size();
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->length - queue->items.size();
+}
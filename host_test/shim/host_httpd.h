@@ -0,0 +1,53 @@
+#pragma once
+// Test-side view of the in-memory httpd in httpd_shim.cpp. Every send,
+// whether through httpd_resp_*, httpd_send or httpd_socket_send, lands in
+// the byte log of its socket, so tests see exactly what a client would.
+#include "esp_http_server.h"
+#include <map>
+#include <string>
+
+namespace host_httpd {
+
+/// One request as a handler sees it; `req.aux` points back here.
+struct Request {
+    httpd_req_t req{};
+    int fd;
+    std::string query;
+    std::map<std::string, std::string> headers;
+    std::string body;  // read by httpd_req_recv
+    size_t bodyRead = 0;
+
+    // Incoming WebSocket frame, read by httpd_ws_recv_frame
+    httpd_ws_type_t wsType = HTTPD_WS_TYPE_TEXT;
+    std::string wsPayload;
+
+    // Response state, as set through httpd_resp_*
+    std::string status = "200 OK";
+    std::string type = "text/html";
+    std::string extraHeaders;
+    bool chunked = false;
+
+    Request(int fd, const char* uri, int method = HTTP_GET);
+};
+
+/// Everything written to `fd` so far.
+std::string Sent(int fd);
+
+/// Lets `fd` accept only `bytes` more before sends would block. Blocking
+/// sends then fail with a timeout, MSG_DONTWAIT sends return
+/// HTTPD_SOCK_ERR_TIMEOUT. SIZE_MAX (the default) is unlimited.
+void SetSendBudget(int fd, size_t bytes);
+
+/// Marks `fd` as an upgraded WebSocket for httpd_ws_get_fd_info.
+void SetWebSocket(int fd);
+
+/// True once httpd_sess_trigger_close was called for `fd`.
+bool IsClosed(int fd);
+
+/// Socket send calls made for `fd`.
+size_t SendCalls(int fd);
+
+/// Forget every socket.
+void Reset();
+
+}  // namespace host_httpd
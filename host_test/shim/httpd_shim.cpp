@@ -0,0 +1,299 @@
+#include "host_httpd.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <mutex>
+
+namespace {
+
+struct Socket {
+    std::string sent;
+    size_t budget = SIZE_MAX;
+    size_t sendCalls = 0;
+    bool websocket = false;
+    bool closed = false;
+};
+
+std::mutex socketsMutex;
+std::map<int, Socket> sockets;
+
+host_httpd::Request& requestOf(httpd_req_t* r)
+{
+    return *static_cast<host_httpd::Request*>(r->aux);
+}
+
+int sendTo(int fd, const char* buf, size_t len, bool dontWait)
+{
+    std::lock_guard<std::mutex> lock(socketsMutex);
+    Socket& s = sockets[fd];
+    s.sendCalls++;
+    if (s.closed)
+        return HTTPD_SOCK_ERR_FAIL;
+    size_t n = len < s.budget ? len : s.budget;
+    if (n == 0 && len > 0)
+        return dontWait ? HTTPD_SOCK_ERR_TIMEOUT : HTTPD_SOCK_ERR_FAIL;
+    s.sent.append(buf, n);
+    if (s.budget != SIZE_MAX)
+        s.budget -= n;
+    return (int)n;
+}
+
+/// Blocking sends either write everything or fail, like httpd_send_all.
+bool sendAll(int fd, const char* buf, size_t len)
+{
+    while (len > 0) {
+        int n = sendTo(fd, buf, len, false);
+        if (n <= 0)
+            return false;
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool sendHeaders(host_httpd::Request& r, const char* lengthHeader)
+{
+    char head[256];
+    int len = snprintf(head, sizeof(head), "HTTP/1.1 %s\r\nContent-Type: %s\r\n", r.status.c_str(), r.type.c_str());
+    std::string all(head, len);
+    all += r.extraHeaders;
+    all += lengthHeader;
+    all += "\r\n";
+    return sendAll(r.fd, all.data(), all.size());
+}
+
+}  // namespace
+
+namespace host_httpd {
+
+Request::Request(int fd, const char* uri, int method)
+    : fd(fd)
+{
+    req.handle = reinterpret_cast<httpd_handle_t>(this);
+    req.method = method;
+    strncpy(const_cast<char*>(req.uri), uri, HTTPD_MAX_URI_LEN);
+    req.aux = this;
+    const char* q = strchr(uri, '?');
+    if (q)
+        query = q + 1;
+}
+
+std::string Sent(int fd)
+{
+    std::lock_guard<std::mutex> lock(socketsMutex);
+    return sockets[fd].sent;
+}
+
+void SetSendBudget(int fd, size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(socketsMutex);
+    sockets[fd].budget = bytes;
+}
+
+void SetWebSocket(int fd)
+{
+    std::lock_guard<std::mutex> lock(socketsMutex);
+    sockets[fd].websocket = true;
+}
+
+bool IsClosed(int fd)
+{
+    std::lock_guard<std::mutex> lock(socketsMutex);
+    return sockets[fd].closed;
+}
+
+size_t SendCalls(int fd)
+{
+    std::lock_guard<std::mutex> lock(socketsMutex);
+    return sockets[fd].sendCalls;
+}
+
+void Reset()
+{
+    std::lock_guard<std::mutex> lock(socketsMutex);
+    sockets.clear();
+}
+
+}  // namespace host_httpd
+
+// Requests
+
+int httpd_req_to_sockfd(httpd_req_t* r)
+{
+    return requestOf(r).fd;
+}
+
+size_t httpd_req_get_hdr_value_len(httpd_req_t* r, const char* field)
+{
+    auto& headers = requestOf(r).headers;
+    auto it = headers.find(field);
+    return it == headers.end() ? 0 : it->second.size();
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t* r, const char* field, char* val, size_t val_size)
+{
+    auto& headers = requestOf(r).headers;
+    auto it = headers.find(field);
+    if (it == headers.end())
+        return ESP_ERR_NOT_FOUND;
+    snprintf(val, val_size, "%s", it->second.c_str());
+    return it->second.size() < val_size ? ESP_OK : ESP_ERR_HTTPD_RESULT_TRUNC;
+}
+
+size_t httpd_req_get_url_query_len(httpd_req_t* r)
+{
+    return requestOf(r).query.size();
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t* r, char* buf, size_t buf_len)
+{
+    const std::string& query = requestOf(r).query;
+    if (query.empty())
+        return ESP_ERR_NOT_FOUND;
+    snprintf(buf, buf_len, "%s", query.c_str());
+    return query.size() < buf_len ? ESP_OK : ESP_ERR_HTTPD_RESULT_TRUNC;
+}
+
+esp_err_t httpd_query_key_value(const char* qry, const char* key, char* val, size_t val_size)
+{
+    size_t keyLen = strlen(key);
+    const char* p = qry;
+    while (p && *p) {
+        const char* end = strchr(p, '&');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len > keyLen && strncmp(p, key, keyLen) == 0 && p[keyLen] == '=') {
+            size_t valueLen = len - keyLen - 1;
+            size_t copy = valueLen < val_size - 1 ? valueLen : val_size - 1;
+            memcpy(val, p + keyLen + 1, copy);
+            val[copy] = '\0';
+            return copy == valueLen ? ESP_OK : ESP_ERR_HTTPD_RESULT_TRUNC;
+        }
+        p = end ? end + 1 : nullptr;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+int httpd_req_recv(httpd_req_t* r, char* buf, size_t buf_len)
+{
+    host_httpd::Request& req = requestOf(r);
+    size_t n = req.body.size() - req.bodyRead;
+    n = n < buf_len ? n : buf_len;
+    memcpy(buf, req.body.data() + req.bodyRead, n);
+    req.bodyRead += n;
+    return (int)n;
+}
+
+// Responses
+
+esp_err_t httpd_resp_set_status(httpd_req_t* r, const char* status)
+{
+    requestOf(r).status = status;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t* r, const char* type)
+{
+    requestOf(r).type = type;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t* r, const char* field, const char* value)
+{
+    host_httpd::Request& req = requestOf(r);
+    req.extraHeaders += std::string(field) + ": " + value + "\r\n";
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t* r, const char* buf, ssize_t buf_len)
+{
+    host_httpd::Request& req = requestOf(r);
+    size_t len = buf_len == HTTPD_RESP_USE_STRLEN ? strlen(buf) : (size_t)buf_len;
+    char contentLength[48];
+    snprintf(contentLength, sizeof(contentLength), "Content-Length: %u\r\n", (unsigned)len);
+    if (!sendHeaders(req, contentLength) || !sendAll(req.fd, buf, len))
+        return ESP_FAIL;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_sendstr(httpd_req_t* r, const char* str)
+{
+    return httpd_resp_send(r, str, str ? HTTPD_RESP_USE_STRLEN : 0);
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t* r, const char* buf, ssize_t buf_len)
+{
+    host_httpd::Request& req = requestOf(r);
+    size_t len = buf_len == HTTPD_RESP_USE_STRLEN ? strlen(buf) : (size_t)buf_len;
+    if (!req.chunked) {
+        req.chunked = true;
+        if (!sendHeaders(req, "Transfer-Encoding: chunked\r\n"))
+            return ESP_FAIL;
+    }
+    char size[16];
+    int n = snprintf(size, sizeof(size), "%x\r\n", (unsigned)len);
+    if (!sendAll(req.fd, size, n) || !sendAll(req.fd, buf, len) || !sendAll(req.fd, "\r\n", 2))
+        return ESP_FAIL;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_sendstr_chunk(httpd_req_t* r, const char* str)
+{
+    return httpd_resp_send_chunk(r, str, str ? HTTPD_RESP_USE_STRLEN : 0);
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t* r, httpd_err_code_t error, const char* msg)
+{
+    static const char* statuses[] = {"500 Internal Server Error", "400 Bad Request", "404 Not Found",
+                                     "405 Method Not Allowed", "408 Request Timeout", "411 Length Required",
+                                     "413 Content Too Large", "414 URI Too Long"};
+    httpd_resp_set_status(r, statuses[error]);
+    httpd_resp_set_type(r, "text/html");
+    return httpd_resp_send(r, msg, HTTPD_RESP_USE_STRLEN);
+}
+
+int httpd_send(httpd_req_t* r, const char* buf, size_t buf_len)
+{
+    return sendAll(requestOf(r).fd, buf, buf_len) ? (int)buf_len : HTTPD_SOCK_ERR_FAIL;
+}
+
+// WebSocket
+
+esp_err_t httpd_ws_recv_frame(httpd_req_t* r, httpd_ws_frame_t* frame, size_t max_len)
+{
+    host_httpd::Request& req = requestOf(r);
+    frame->type = req.wsType;
+    frame->final = true;
+    if (max_len == 0) {
+        frame->len = req.wsPayload.size();
+        return ESP_OK;
+    }
+    if (max_len < req.wsPayload.size())
+        return ESP_ERR_INVALID_SIZE;
+    memcpy(frame->payload, req.wsPayload.data(), req.wsPayload.size());
+    frame->len = req.wsPayload.size();
+    return ESP_OK;
+}
+
+// Sockets and sessions
+
+int httpd_socket_send(httpd_handle_t hd, int sockfd, const char* buf, size_t buf_len, int flags)
+{
+    return sendTo(sockfd, buf, buf_len, flags & MSG_DONTWAIT);
+}
+
+esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd)
+{
+    std::lock_guard<std::mutex> lock(socketsMutex);
+    sockets[sockfd].closed = true;
+    return ESP_OK;
+}
+
+httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t hd, int fd)
+{
+    std::lock_guard<std::mutex> lock(socketsMutex);
+    auto it = sockets.find(fd);
+    if (it == sockets.end() || it->second.closed)
+        return HTTPD_WS_CLIENT_INVALID;
+    return it->second.websocket ? HTTPD_WS_CLIENT_WEBSOCKET : HTTPD_WS_CLIENT_HTTP;
+}
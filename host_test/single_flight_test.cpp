@@ -0,0 +1,198 @@
+// Concurrent reads of the same bytes share one read, clients that fail,
+// go away or stall do not hold up the rest, and a read error reaches every
+// client.
+// Worth running under ThreadSanitizer as well:
+//   cmake -S host_test -B build/tsan -DHOST_TEST_TSAN=ON && cmake --build build/tsan
+//   ./build/tsan/single_flight_test
+#include "check.h"
+#include "SingleFlight.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Flights = SingleFlight<2, 4>;
+using Sink = Flights::Sink;
+
+std::atomic<int> reads{0};
+std::string data;
+
+/// The file in 4 KB blocks, `blockUs` apart.
+esp_err_t source(const Sink& out, int blockUs)
+{
+    reads++;
+    for (size_t pos = 0; pos < data.size(); pos += 4096) {
+        std::this_thread::sleep_for(std::chrono::microseconds(blockUs));
+        if (!out(data.data() + pos, std::min<size_t>(4096, data.size() - pos)))
+            return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/// A read that starts late enough for every client to join it.
+esp_err_t slowStart(const Sink& out, int blockUs)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return source(out, blockUs);
+}
+
+void joinAll(std::vector<std::thread>& threads)
+{
+    for (std::thread& t : threads)
+        t.join();
+    threads.clear();
+}
+
+}  // namespace
+
+int main()
+{
+    data.assign(100000, 'x');
+    for (int i = 0; i < 8; i++)
+        data[i * 1000] = (char)('a' + i);
+
+    Flights flights(pdMS_TO_TICKS(50));
+    std::vector<std::thread> threads;
+
+    // A leader and four followers: one read, everyone gets the whole file
+    {
+        reads = 0;
+        std::vector<std::string> got(5);
+        std::vector<esp_err_t> rc(5, ESP_FAIL);
+        for (int i = 0; i < 5; i++) {
+            threads.emplace_back([&, i] {
+                rc[i] = flights.Run("/fat/index.html", 0, data.size(),
+                    [&, i](const char* p, size_t n) { got[i].append(p, n); return true; },
+                    [](const Sink& out) { return slowStart(out, 100); });
+            });
+        }
+        joinAll(threads);
+        CHECK_EQ(reads.load(), 1);
+        for (int i = 0; i < 5; i++)
+            CHECK(rc[i] == ESP_OK && got[i] == data);
+    }
+
+    // Two clients drop after a few blocks, whoever leads; the third still
+    // gets everything from the one read
+    {
+        reads = 0;
+        std::vector<std::string> got(3);
+        std::vector<esp_err_t> rc(3, ESP_FAIL);
+        for (int i = 0; i < 3; i++) {
+            threads.emplace_back([&, i] {
+                int blocks = 0;
+                rc[i] = flights.Run("/fat/app.js", 0, data.size(),
+                    [&, i](const char* p, size_t n) {
+                        if (i != 2 && ++blocks > 3)
+                            return false;
+                        got[i].append(p, n);
+                        return true;
+                    },
+                    [](const Sink& out) { return slowStart(out, 50); });
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));  // client 0 leads
+        }
+        joinAll(threads);
+        CHECK_EQ(reads.load(), 1);
+        CHECK(rc[0] == ESP_FAIL && rc[1] == ESP_FAIL);
+        CHECK(rc[2] == ESP_OK && got[2] == data);
+    }
+
+    // A failed read fails every client of the flight
+    {
+        reads = 0;
+        std::vector<esp_err_t> rc(3, ESP_OK);
+        for (int i = 0; i < 3; i++) {
+            threads.emplace_back([&, i] {
+                rc[i] = flights.Run("/fat/bad", 0, 10, [](const char*, size_t) { return true; },
+                    [](const Sink&) {
+                        reads++;
+                        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                        return ESP_FAIL;
+                    });
+            });
+        }
+        joinAll(threads);
+        CHECK_EQ(reads.load(), 1);
+        for (esp_err_t r : rc)
+            CHECK(r == ESP_FAIL);
+    }
+
+    // Other files or ranges do not join; with both flights taken the third
+    // read goes alone
+    {
+        reads = 0;
+        std::vector<esp_err_t> rc(3, ESP_FAIL);
+        for (int i = 0; i < 3; i++) {
+            threads.emplace_back([&, i] {
+                rc[i] = flights.Run(i == 0 ? "/fat/a" : "/fat/b", i == 2 ? 5 : 0, data.size(),
+                    [](const char*, size_t) { return true; },
+                    [](const Sink& out) { return slowStart(out, 0); });
+            });
+        }
+        joinAll(threads);
+        CHECK_EQ(reads.load(), 3);
+        for (esp_err_t r : rc)
+            CHECK(r == ESP_OK);
+    }
+
+    // A follower that sits on a block past the ack timeout is dropped; the
+    // leader and the other follower finish without it, and the flight is
+    // free again once it comes back
+    {
+        reads = 0;
+        std::vector<std::string> got(3);
+        std::vector<esp_err_t> rc(3, ESP_OK);
+        std::vector<std::chrono::steady_clock::time_point> done(3);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 3; i++) {
+            threads.emplace_back([&, i] {
+                rc[i] = flights.Run("/fat/stall.js", 0, data.size(),
+                    [&, i](const char* p, size_t n) {
+                        if (i == 2 && got[i].size() == 4096)
+                            std::this_thread::sleep_for(std::chrono::milliseconds(400));
+                        got[i].append(p, n);
+                        return true;
+                    },
+                    [](const Sink& out) { return slowStart(out, 0); });
+                done[i] = std::chrono::steady_clock::now();
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));  // client 0 leads
+        }
+        joinAll(threads);
+        CHECK_EQ(reads.load(), 1);
+        CHECK(rc[0] == ESP_OK && got[0] == data);
+        CHECK(rc[1] == ESP_OK && got[1] == data);
+        CHECK(rc[2] == ESP_FAIL && got[2].size() < data.size());
+        CHECK(done[0] - start < std::chrono::milliseconds(300));
+        CHECK(done[1] - start < std::chrono::milliseconds(300));
+
+        std::string again;
+        CHECK(flights.Run("/fat/stall.js", 0, data.size(),
+                  [&](const char* p, size_t n) { again.append(p, n); return true; },
+                  [](const Sink& out) { return source(out, 0); }) == ESP_OK);
+        CHECK(again == data);
+    }
+
+    // Back-to-back flights reuse the table without leaking state
+    for (int round = 0; round < 200; round++) {
+        std::vector<std::string> got(4);
+        std::vector<esp_err_t> rc(4, ESP_FAIL);
+        for (int i = 0; i < 4; i++) {
+            threads.emplace_back([&, i] {
+                rc[i] = flights.Run(i % 2 ? "/fat/x" : "/fat/y", 0, data.size(),
+                    [&, i](const char* p, size_t n) { got[i].append(p, n); return true; },
+                    [](const Sink& out) { return source(out, 0); });
+            });
+        }
+        joinAll(threads);
+        for (int i = 0; i < 4; i++)
+            CHECK(rc[i] == ESP_OK && got[i] == data);
+    }
+
+    return TestResult("single_flight_test");
+}
@@ -0,0 +1,156 @@
+// Cost of fanning one guest event out to N SSE clients: the shared path
+// (HttpSseEndpoint::BroadcastEvent renders once and queues references)
+// against rendering the event into every client's queue through
+// ForEachClient, as GuestSseEndpoint did before frames were shared.
+// Only the publishing side is timed; the writer task drains in between.
+//   sse_fanout_bench [--quick]
+#include "check.h"
+#include "host_httpd.h"
+#include "HttpSseEndpoint.h"
+#include "json.h"
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Endpoint = HttpSseEndpoint<8, 8, 256, 32>;
+using Clock = std::chrono::steady_clock;
+
+struct Client {
+    std::unique_ptr<host_httpd::Request> request;
+};
+
+struct Result {
+    double nsPerEvent;
+    double rendersPerEvent;
+    double sendsPerEvent;
+    double framesPerEvent;
+};
+
+uint32_t renders = 0;
+
+void render(Stream& s, uint32_t n)
+{
+    renders++;
+    JsonObjectWriter::create(s, [&](JsonObjectWriter& obj) {
+        obj.field("mac", "AA:BB:CC:DD:EE:01");
+        obj.field("event", "score");
+        obj.field("value", (int64_t)n);
+        obj.field("name", "Team Firefly");
+    });
+}
+
+void connect(Endpoint& sse, std::vector<Client>& clients, size_t count, int firstFd)
+{
+    for (size_t i = 0; i < count; i++) {
+        auto req = std::make_unique<host_httpd::Request>(firstFd + (int)i, "/api/guests/events");
+        CHECK_EQ(sse.handle(&req->req), ESP_OK);
+        clients.push_back({std::move(req)});
+    }
+}
+
+void disconnect(std::vector<Client>& clients)
+{
+    for (Client& c : clients)
+        c.request->req.free_ctx(c.request->req.sess_ctx);
+    clients.clear();
+}
+
+/// Waits until every client's queue is empty and returns the frames sent.
+uint32_t drain(Endpoint& sse, size_t count)
+{
+    while (true) {
+        bool idle = true;
+        uint32_t sent = 0;
+        for (size_t i = 0; i < count; i++) {
+            HttpSseEndpointBase::ClientStats stats;
+            if (sse.GetClientStats(i, stats)) {
+                idle &= stats.depth == 0;
+                sent += stats.sent;
+                CHECK_EQ(stats.dropped, 0u);
+            }
+        }
+        if (idle)
+            return sent;
+        std::this_thread::yield();
+    }
+}
+
+template <typename PUBLISH>
+Result run(Endpoint& sse, size_t clientCount, uint32_t events, int firstFd, PUBLISH publish)
+{
+    std::vector<Client> clients;
+    connect(sse, clients, clientCount, firstFd);
+    HttpSseEndpointBase::FanoutStats before = sse.GetFanoutStats();
+    size_t sendsBefore = 0;
+    for (size_t i = 0; i < clientCount; i++)
+        sendsBefore += host_httpd::SendCalls(firstFd + (int)i);
+    renders = 0;
+
+    // Drain after every event so no queue overflows; the JSON writer
+    // flushes per field, so the per-client path queues several frames each
+    Clock::duration spent{};
+    for (uint32_t n = 0; n < events; n++) {
+        Clock::time_point start = Clock::now();
+        publish(n);
+        spent += Clock::now() - start;
+        drain(sse, clientCount);
+    }
+    uint32_t frames = drain(sse, clientCount);
+
+    size_t sends = 0;
+    for (size_t i = 0; i < clientCount; i++)
+        sends += host_httpd::SendCalls(firstFd + (int)i);
+    HttpSseEndpointBase::FanoutStats after = sse.GetFanoutStats();
+    CHECK_EQ(after.deliveries - before.deliveries, frames);
+    disconnect(clients);
+
+    return Result{
+        std::chrono::duration<double, std::nano>(spent).count() / events,
+        (double)renders / events,
+        (double)(sends - sendsBefore) / events,
+        (double)frames / events,
+    };
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+    uint32_t events = quick ? 200 : 20000;
+
+    // Kept alive until exit: its writer task cannot be stopped on the host
+    Endpoint& sse = *new Endpoint();
+    int fd = 100;
+
+    printf("%-8s %-11s %10s %14s %13s %12s\n", "clients", "path", "ns/event", "renders/event", "frames/event",
+           "sends/event");
+    for (size_t clients : {1, 4, 8}) {
+        Result shared = run(sse, clients, events, fd, [&](uint32_t n) {
+            sse.BroadcastEvent(SseAcceptAll::Tag{}, 0, [&](Stream& s) { render(s, n); });
+        });
+        fd += clients;
+
+        Result perClient = run(sse, clients, events, fd, [&](uint32_t n) {
+            sse.ForEachClient([&](Stream& s) {
+                s.write("data: ", 6);
+                render(s, n);
+                s.write("\n\n", 2);
+                return true;
+            });
+        });
+        fd += clients;
+
+        for (const auto& [name, r] : {std::pair{"shared", shared}, std::pair{"per-client", perClient}})
+            printf("%-8u %-11s %10.0f %14.2f %13.2f %12.2f\n", (unsigned)clients, name, r.nsPerEvent,
+                   r.rendersPerEvent, r.framesPerEvent, r.sendsPerEvent);
+
+        CHECK(shared.rendersPerEvent == 1.0);
+        CHECK(shared.framesPerEvent == (double)clients);
+        CHECK(perClient.rendersPerEvent == (double)clients);
+    }
+    return TestResult("sse_fanout_bench");
+}
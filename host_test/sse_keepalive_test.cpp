@@ -0,0 +1,83 @@
+// Keepalives go only to SSE clients that have had nothing queued for a
+// full idle interval.
+#include "check.h"
+#include "host_httpd.h"
+#include "HttpSseEndpoint.h"
+#include <string>
+#include <thread>
+
+namespace {
+
+/// `?only=<n>` subscribes to events tagged n; no query accepts everything.
+struct ChannelFilter {
+    struct Tag {
+        int channel = 0;
+    };
+    int only = -1;
+    bool Parse(const char* query)
+    {
+        char value[8];
+        if (httpd_query_key_value(query, "only", value, sizeof(value)) == ESP_OK)
+            only = atoi(value);
+        return true;
+    }
+    bool Matches(const Tag& tag) const { return only < 0 || tag.channel == only; }
+};
+
+using Endpoint = HttpSseEndpoint<4, 8, 256, 8, ChannelFilter>;
+
+constexpr TickType_t Idle = pdMS_TO_TICKS(100);
+
+size_t keepAlives(int fd)
+{
+    std::string sent = host_httpd::Sent(fd);
+    size_t count = 0;
+    for (size_t at = sent.find(": keepalive"); at != std::string::npos; at = sent.find(": keepalive", at + 1))
+        count++;
+    return count;
+}
+
+void settle()
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+}  // namespace
+
+int main()
+{
+    Endpoint& sse = *new Endpoint();
+    host_httpd::Request busy(1, "/events?only=1");
+    host_httpd::Request quiet(2, "/events?only=2");
+    CHECK_EQ(sse.handle(&busy.req), ESP_OK);
+    CHECK_EQ(sse.handle(&quiet.req), ESP_OK);
+
+    // Nobody has been idle yet: nothing sent, next check due within Idle
+    TickType_t wait = sse.SendKeepAlive(Idle);
+    CHECK(wait > 0 && wait <= Idle);
+    settle();
+    CHECK_EQ(keepAlives(1), 0u);
+    CHECK_EQ(keepAlives(2), 0u);
+
+    // Events keep the busy client from ever looking idle
+    TickType_t start = xTaskGetTickCount();
+    while (xTaskGetTickCount() - start < 3 * Idle) {
+        sse.BroadcastEvent(ChannelFilter::Tag{1}, 0, [](Stream& s) { s.write("{}", 2); });
+        vTaskDelay(Idle / 4);
+        sse.SendKeepAlive(Idle);
+    }
+    settle();
+    CHECK_EQ(keepAlives(1), 0u);
+    CHECK(keepAlives(2) >= 2);
+
+    // A keepalive restarts the idle interval like any other frame
+    vTaskDelay(Idle + 10);
+    size_t before = keepAlives(2);
+    sse.SendKeepAlive(Idle);
+    wait = sse.SendKeepAlive(Idle);
+    settle();
+    CHECK_EQ(keepAlives(2), before + 1);
+    CHECK(wait > Idle / 2);
+
+    return TestResult("sse_keepalive_test");
+}
@@ -0,0 +1,144 @@
+// WebSocket frames are queued per client and written without blocking: a
+// stalled socket backs up only its own queue, and control replies go out
+// through the same queue as broadcasts.
+#include "check.h"
+#include "host_httpd.h"
+#include "HttpWsEndpoint.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct AcceptAll {
+    struct Tag {
+    };
+    bool Parse(const char*) { return true; }
+    bool Matches(const Tag&) const { return true; }
+};
+
+class Endpoint : public HttpWsEndpoint<4, 256, AcceptAll, 4> {
+protected:
+    void OnFrame(Client& client, const httpd_ws_frame_t& frame) override
+    {
+        Send(client, HTTPD_WS_TYPE_TEXT, frame.payload, frame.len);
+    }
+};
+
+struct Frame {
+    uint8_t opcode;
+    std::string payload;
+};
+
+/// Splits what the endpoint wrote to `fd` into unmasked server frames.
+std::vector<Frame> framesSent(int fd)
+{
+    std::string sent = host_httpd::Sent(fd);
+    std::vector<Frame> frames;
+    size_t at = 0;
+    while (at + 2 <= sent.size()) {
+        uint8_t opcode = (uint8_t)sent[at] & 0x0F;
+        size_t len = (uint8_t)sent[at + 1] & 0x7F;
+        size_t header = 2;
+        if (len == 126) {
+            len = ((uint8_t)sent[at + 2] << 8) | (uint8_t)sent[at + 3];
+            header = 4;
+        }
+        if (at + header + len > sent.size())
+            break;
+        frames.push_back({opcode, sent.substr(at + header, len)});
+        at += header + len;
+    }
+    return frames;
+}
+
+/// Waits up to a second for the writer to put `count` frames on `fd`.
+void waitForFrames(int fd, size_t count)
+{
+    for (int i = 0; i < 100 && framesSent(fd).size() < count; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+void settle()
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+void broadcast(Endpoint& ws, const char* text)
+{
+    Endpoint::Payload payloads[Endpoint::FormatCount] = {{text, strlen(text)}, {text, strlen(text)}, {}};
+    ws.Broadcast(AcceptAll::Tag{}, payloads);
+}
+
+}  // namespace
+
+int main()
+{
+    // Kept alive until exit: its writer task cannot be stopped on the host
+    Endpoint& ws = *new Endpoint();
+    host_httpd::Request fast(1, "/ws");
+    host_httpd::Request stalled(2, "/ws?format=binary");
+    CHECK_EQ(ws.handle(&fast.req), ESP_OK);
+    CHECK_EQ(ws.handle(&stalled.req), ESP_OK);
+
+    // A socket that accepts nothing does not hold up the broadcaster or the
+    // other client; its queue keeps the newest QueueDepth frames
+    host_httpd::SetSendBudget(2, 0);
+    const char* texts[] = {"a", "b", "c", "d", "e", "f"};
+    for (size_t i = 0; i < 6; i++) {
+        auto start = std::chrono::steady_clock::now();
+        broadcast(ws, texts[i]);
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20));
+        waitForFrames(1, i + 1);
+    }
+
+    std::vector<Frame> frames = framesSent(1);
+    CHECK_EQ(frames.size(), 6u);
+    for (size_t i = 0; i < frames.size() && i < 6; i++) {
+        CHECK_EQ(frames[i].opcode, (uint8_t)HTTPD_WS_TYPE_TEXT);
+        CHECK_STR(frames[i].payload.c_str(), texts[i]);
+    }
+    CHECK(host_httpd::Sent(2).empty());
+    CHECK_EQ(ws.GetStats().txDropped, 2u);
+
+    host_httpd::SetSendBudget(2, SIZE_MAX);
+    waitForFrames(2, 4);
+    frames = framesSent(2);
+    CHECK_EQ(frames.size(), 4u);
+    if (frames.size() == 4) {
+        CHECK_EQ(frames[0].opcode, (uint8_t)HTTPD_WS_TYPE_BINARY);
+        CHECK_STR(frames[0].payload.c_str(), "c");
+        CHECK_STR(frames[3].payload.c_str(), "f");
+    }
+
+    // Text frames reach OnFrame; PING is answered with a queued PONG
+    fast.wsType = HTTPD_WS_TYPE_TEXT;
+    fast.wsPayload = "hello";
+    fast.req.method = HTTP_POST;
+    CHECK_EQ(ws.handle(&fast.req), ESP_OK);
+    fast.wsType = HTTPD_WS_TYPE_PING;
+    fast.wsPayload = "p";
+    CHECK_EQ(ws.handle(&fast.req), ESP_OK);
+    waitForFrames(1, 8);
+    frames = framesSent(1);
+    CHECK_EQ(frames.size(), 8u);
+    if (frames.size() == 8) {
+        CHECK_STR(frames[6].payload.c_str(), "hello");
+        CHECK_EQ(frames[7].opcode, (uint8_t)HTTPD_WS_TYPE_PONG);
+        CHECK_STR(frames[7].payload.c_str(), "p");
+    }
+    CHECK_EQ(ws.GetStats().rxFrames, 1u);
+
+    // CLOSE is echoed with its status code, then the session is closed
+    fast.wsType = HTTPD_WS_TYPE_CLOSE;
+    fast.wsPayload = std::string("\x03\xE8", 2);
+    CHECK_EQ(ws.handle(&fast.req), ESP_OK);
+    settle();
+    frames = framesSent(1);
+    CHECK(!frames.empty() && frames.back().opcode == HTTPD_WS_TYPE_CLOSE);
+    CHECK(!frames.empty() && frames.back().payload == fast.wsPayload);
+    CHECK(host_httpd::IsClosed(1));
+    CHECK(!host_httpd::IsClosed(2));
+
+    return TestResult("ws_queue_test");
+}
@@ -20,8 +20,10 @@ public:
             return;
 
         hardwareManager.init();
+        ftpManager.SetChangeHandler([this](const char* path) { webManager.OnFileChanged(path); });
         ftpManager.init();
         espNowManager.Init();
+        webManager.UseAssetBundle(hardwareManager.GetAssetsPartition());
         webManager.init();
 
        // hardwareManager.GetEthernetDriver().SetStaticIp("192.168.1.50", "192.168.1.1", "255.255.255.0");
@@ -7,49 +7,16 @@
 #include "esp_netif.h"
 #include "nvs_flash.h"
 #include <cstring>
+#include "EspNowMessage.h"
+#include "EspNowTransmitter.h"
 
 
-// --- Broadcast address ---
-static constexpr uint8_t BROADCAST_MAC[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-
-// --- Enum for event types ---
-enum espnow_message_event_t : uint8_t
-{
-    ESPNOW_MESSAGE_EVENT_BUTTON_PRESS = 0,
-    ESPNOW_MESSAGE_EVENT_STARTUP = 1,
-    ESPNOW_MESSAGE_EVENT_SCORE_UPDATE = 2,
-};
-
-// --- Compact binary message struct ---
-typedef struct __attribute__((packed))
-{
-    char name[8];
-    espnow_message_event_t event;
-    int32_t value;
-    uint8_t destinationMac[6];
-} espnow_message_t;
-
-static const char *EventToString(espnow_message_event_t e)
-{
-    switch (e)
-    {
-    case ESPNOW_MESSAGE_EVENT_BUTTON_PRESS:
-        return "button";
-    case ESPNOW_MESSAGE_EVENT_STARTUP:
-        return "startup";
-    case ESPNOW_MESSAGE_EVENT_SCORE_UPDATE:
-        return "score";
-    default:
-        return "UNKNOWN";
-    }
-}
-
 class EspNowManager
 {
     constexpr static const char *TAG = "EspNowManager";
 
 public:
-    // --- Packet structure for queue ---
+    // --- Packet structure for the receive bus ---
     struct Packet
     {
         uint8_t mac[6];
@@ -57,6 +24,9 @@ public:
         int len;
     };
 
+    using PacketBus = EventBus<Packet, 16, 4>;
+    using Subscriber = PacketBus::Subscriber;
+
     EspNowManager()
     {
         instance = this;
@@ -84,6 +54,7 @@ public:
 
         ESP_ERROR_CHECK(esp_now_init());
         ESP_ERROR_CHECK(esp_now_register_recv_cb(OnReceive));
+        ESP_ERROR_CHECK(esp_now_register_send_cb(OnSent));
 
         // Add broadcast peer
         esp_now_peer_info_t peerInfo = {};
@@ -93,7 +64,7 @@ public:
         peerInfo.encrypt = false;
         ESP_ERROR_CHECK(esp_now_add_peer(&peerInfo));
 
-        recvQueue = xQueueCreate(8, sizeof(Packet));
+        transmitter.Start(BROADCAST_MAC);
 
         task.Init("EspNow", 7, 4096);
         task.SetHandler([this]() { Work(); });
@@ -104,32 +75,31 @@ public:
         ESP_LOGI(TAG, "ESP-NOW initialized and ready.");
     }
 
-    bool Read(Packet &package, TickType_t timeoutTicks)
+    /// Every subscriber sees every received packet through its own cursor.
+    /// Subscribing is allowed before Init; returns nullptr when all slots are taken.
+    Subscriber *Subscribe(const char *name)
     {
-        REQUIRE_READY(initGuard);
-        return xQueueReceive(recvQueue, &package, timeoutTicks) == pdTRUE;
+        Subscriber *s = bus.Subscribe(name);
+        if (!s)
+            ESP_LOGE(TAG, "No free bus subscriber slot for %s", name);
+        return s;
     }
 
     // --- Sending functions ---
-    bool Send(const espnow_message_t &msg)
-    {
-        esp_err_t result = esp_now_send(
-            BROADCAST_MAC,
-            reinterpret_cast<const uint8_t *>(&msg),
-            sizeof(msg));
+    // All frames go through the TX task; these only queue and never wait on the radio.
 
-        if (result == ESP_OK)
-        {
-            ESP_LOGI(TAG, "Sent event=%s value=%ld name=%s, dstMac=%02X:%02X:%02X:%02X:%02X:%02X",
-                     EventToString(msg.event), (long)msg.value, msg.name,
-                     msg.destinationMac[0], msg.destinationMac[1], msg.destinationMac[2],
-                     msg.destinationMac[3], msg.destinationMac[4], msg.destinationMac[5]);
-                     
-            return true;
-        }
+    /// Returns the command id for GetReceipt, or 0 when the TX queue is full.
+    uint32_t Submit(const espnow_message_t &msg, TickType_t timeout = 0)
+    {
+        uint32_t id = transmitter.Submit(msg, timeout);
+        if (id == 0)
+            ESP_LOGW(TAG, "TX queue full, dropping event=%s", EventToString(msg.event));
+        return id;
+    }
 
-        ESP_LOGE(TAG, "ESP-NOW send failed: %s", esp_err_to_name(result));
-        return false;
+    bool Send(const espnow_message_t &msg)
+    {
+        return Submit(msg) != 0;
     }
 
     bool SendEvent(espnow_message_event_t event, int32_t value,
@@ -143,35 +113,46 @@ public:
         return Send(msg);
     }
 
+    bool GetReceipt(uint32_t id, EspNowTransmitter::Receipt &out) const { return transmitter.GetReceipt(id, out); }
+    EspNowTransmitter::Stats GetTxStats() const { return transmitter.GetStats(); }
+
     const uint8_t *GetMacAddress() const { return myMac; }
 
 private:
     InitGuard initGuard;
     Mutex mutex;
     Task task;
-    QueueHandle_t recvQueue = nullptr;
+    PacketBus bus;
+    EspNowTransmitter transmitter;
     uint8_t myMac[6] = {0};
+    uint32_t reportedDrops = 0;
 
     static inline EspNowManager *instance = nullptr;
 
+    static void OnSent(const esp_now_send_info_t *tx_info, esp_now_send_status_t status)
+    {
+        if (instance)
+            instance->transmitter.OnSendComplete(status);
+    }
+
     static void OnReceive(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len)
     {
         if (!recv_info || !data || len <= 0)
             return;
 
-        if (!instance || !instance->recvQueue)
+        if (!instance)
             return;
 
         // Filter self
         if (memcmp(recv_info->src_addr, instance->myMac, 6) == 0)
             return;
 
-        // Enqueue packet
-        Packet pkt{};
-        memcpy(pkt.mac, recv_info->src_addr, 6);
-        pkt.len = len < sizeof(pkt.data) ? len : sizeof(pkt.data);
-        memcpy(pkt.data, data, pkt.len);
-        xQueueSend(instance->recvQueue, &pkt, 0);
+        // Written once into the shared ring, straight from the radio buffer
+        instance->bus.Publish([&](Packet &pkt) {
+            memcpy(pkt.mac, recv_info->src_addr, 6);
+            pkt.len = len < sizeof(pkt.data) ? len : sizeof(pkt.data);
+            memcpy(pkt.data, data, pkt.len);
+        });
     }
 
     void Work()
@@ -179,6 +160,27 @@ private:
         while (true)
         {
             vTaskDelay(pdMS_TO_TICKS(1000));
+            reportLag();
         }
     }
+
+    /// Log subscribers that lost packets since the last report.
+    void reportLag()
+    {
+        uint32_t drops = bus.GetPublishDrops();
+        bus.ForEachSubscriber([&](const Subscriber &s) {
+            drops += s.GetStats().dropped;
+        });
+        if (drops == reportedDrops)
+            return;
+        reportedDrops = drops;
+
+        ESP_LOGW(TAG, "Packet bus: published=%lu busy=%lu",
+                 (unsigned long)bus.GetPublished(), (unsigned long)bus.GetPublishDrops());
+        bus.ForEachSubscriber([&](const Subscriber &s) {
+            Subscriber::Stats st = s.GetStats();
+            ESP_LOGW(TAG, "  %s: received=%lu dropped=%lu lag=%lu", s.GetName(),
+                     (unsigned long)st.received, (unsigned long)st.dropped, (unsigned long)st.lag);
+        });
+    }
 };
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+
+// --- Broadcast address ---
+static constexpr uint8_t BROADCAST_MAC[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+// --- Enum for event types ---
+enum espnow_message_event_t : uint8_t
+{
+    ESPNOW_MESSAGE_EVENT_BUTTON_PRESS = 0,
+    ESPNOW_MESSAGE_EVENT_STARTUP = 1,
+    ESPNOW_MESSAGE_EVENT_SCORE_UPDATE = 2,
+    ESPNOW_MESSAGE_EVENT_BLINK = 3,
+};
+
+// --- Compact binary message struct ---
+typedef struct __attribute__((packed))
+{
+    char name[8];
+    espnow_message_event_t event;
+    int32_t value;
+    uint8_t destinationMac[6];
+} espnow_message_t;
+
+static const char *EventToString(espnow_message_event_t e)
+{
+    switch (e)
+    {
+    case ESPNOW_MESSAGE_EVENT_BUTTON_PRESS:
+        return "button";
+    case ESPNOW_MESSAGE_EVENT_STARTUP:
+        return "startup";
+    case ESPNOW_MESSAGE_EVENT_SCORE_UPDATE:
+        return "score";
+    case ESPNOW_MESSAGE_EVENT_BLINK:
+        return "blink";
+    default:
+        return "UNKNOWN";
+    }
+}
@@ -0,0 +1,283 @@
+#pragma once
+#include "rtos.h"
+#include "EspNowMessage.h"
+#include "esp_log.h"
+#include "esp_now.h"
+#include "esp_timer.h"
+#include <atomic>
+#include <cstring>
+
+/// Dedicated ESP-NOW TX task fed by a bounded command queue.
+/// Submit() returns a command id immediately; the task sends one frame at a
+/// time and waits for the send callback. The radio calls back once per
+/// accepted frame, in send order, so callbacks are numbered as they arrive
+/// and only the one matching the frame in flight completes it; a callback
+/// that turns up after its frame timed out is dropped rather than credited to
+/// the next command. Receipts for the most recent commands can be looked up
+/// by id.
+class EspNowTransmitter
+{
+    constexpr static const char *TAG = "EspNowTransmitter";
+    constexpr static size_t QueueDepth = 32;
+    constexpr static size_t ReceiptDepth = 64;
+    constexpr static int NoMemRetries = 5;
+    constexpr static TickType_t SendTimeout = pdMS_TO_TICKS(100);
+
+public:
+    enum class State : uint8_t
+    {
+        Unknown, // never submitted, or receipt already recycled
+        Queued,
+        InFlight,
+        Sent,
+        Failed,
+    };
+
+    struct Receipt
+    {
+        uint32_t id = 0;
+        State state = State::Unknown;
+        uint32_t queueUs = 0; // submit -> handed to the radio
+        uint32_t airUs = 0;   // handed to the radio -> send callback
+    };
+
+    struct Stats
+    {
+        uint32_t submitted = 0;
+        uint32_t rejected = 0; // queue full
+        uint32_t sent = 0;
+        uint32_t failed = 0;
+        uint32_t timeouts = 0; // no send callback within SendTimeout
+        uint32_t lateCallbacks = 0; // callbacks for frames that already timed out
+        uint32_t queueUsMax = 0;
+        uint64_t queueUsTotal = 0;
+        uint32_t airUsMax = 0;
+        uint64_t airUsTotal = 0;
+    };
+
+    static const char *StateToString(State s)
+    {
+        switch (s)
+        {
+        case State::Queued:
+            return "queued";
+        case State::InFlight:
+            return "inflight";
+        case State::Sent:
+            return "sent";
+        case State::Failed:
+            return "failed";
+        default:
+            return "unknown";
+        }
+    }
+
+    void Start(const uint8_t *destination)
+    {
+        memcpy(dest, destination, sizeof(dest));
+        task.Init("EspNowTx", 7, 3072);
+        task.SetHandler([this]() { run(); });
+        task.Run();
+    }
+
+    /// Queue `msg` for transmission. Returns its command id, or 0 when the
+    /// queue stays full for `timeout`. Never waits on the radio.
+    uint32_t Submit(const espnow_message_t &msg, TickType_t timeout = 0)
+    {
+        Command cmd;
+        cmd.id = nextId.fetch_add(1);
+        if (cmd.id == 0)
+            cmd.id = nextId.fetch_add(1); // 0 means rejected
+        cmd.queuedAt = esp_timer_get_time();
+        cmd.msg = msg;
+
+        {
+            LOCK(mutex);
+            Slot &slot = receipts[cmd.id % ReceiptDepth];
+            slot = Slot{};
+            slot.id = cmd.id;
+            slot.state = State::Queued;
+            slot.queuedAt = cmd.queuedAt;
+        }
+
+        if (!queue.Push(cmd, timeout))
+        {
+            LOCK(mutex);
+            receipts[cmd.id % ReceiptDepth].state = State::Failed;
+            stats.rejected++;
+            return 0;
+        }
+
+        LOCK(mutex);
+        stats.submitted++;
+        return cmd.id;
+    }
+
+    bool GetReceipt(uint32_t id, Receipt &out) const
+    {
+        LOCK(mutex);
+        const Slot &slot = receipts[id % ReceiptDepth];
+        if (id == 0 || slot.id != id)
+            return false;
+
+        out.id = id;
+        out.state = slot.state;
+        out.queueUs = slot.sentAt ? (uint32_t)(slot.sentAt - slot.queuedAt) : 0;
+        out.airUs = slot.doneAt ? (uint32_t)(slot.doneAt - slot.sentAt) : 0;
+        return true;
+    }
+
+    Stats GetStats() const
+    {
+        LOCK(mutex);
+        return stats;
+    }
+
+    /// Forwarded from the ESP-NOW send callback (Wi-Fi task).
+    void OnSendComplete(esp_now_send_status_t status)
+    {
+        uint32_t seq = callbackSeq.fetch_add(1) + 1;
+        completion.store(packCompletion(seq, status == ESP_NOW_SEND_SUCCESS), std::memory_order_release);
+        sendDone.Give();
+    }
+
+private:
+    struct Command
+    {
+        uint32_t id;
+        int64_t queuedAt;
+        espnow_message_t msg;
+    };
+
+    struct Slot
+    {
+        uint32_t id = 0;
+        State state = State::Unknown;
+        int64_t queuedAt = 0;
+        int64_t sentAt = 0;
+        int64_t doneAt = 0;
+    };
+
+    Task task;
+    Queue<Command> queue{QueueDepth};
+    Semaphore sendDone;
+    uint32_t sendSeq = 0;                 // frames accepted by esp_now_send (TX task only)
+    std::atomic<uint32_t> callbackSeq{0}; // send callbacks received
+    std::atomic<uint32_t> completion{0};  // latest callback: sequence and outcome
+    std::atomic<uint32_t> nextId{1};
+    uint8_t dest[6] = {0};
+
+    Mutex mutex;
+    Slot receipts[ReceiptDepth];
+    Stats stats;
+
+    void run()
+    {
+        while (true)
+        {
+            Command cmd;
+            if (!queue.Pop(cmd, portMAX_DELAY))
+                continue;
+
+            int64_t sentAt = esp_timer_get_time();
+            update(cmd.id, State::InFlight, [&](Slot &slot) {
+                slot.sentAt = sentAt;
+                uint32_t waited = (uint32_t)(sentAt - cmd.queuedAt);
+                stats.queueUsTotal += waited;
+                if (waited > stats.queueUsMax)
+                    stats.queueUsMax = waited;
+            });
+
+            esp_err_t err = send(cmd.msg);
+            if (err != ESP_OK)
+            {
+                ESP_LOGE(TAG, "ESP-NOW send of #%lu failed: %s", (unsigned long)cmd.id, esp_err_to_name(err));
+                update(cmd.id, State::Failed, [&](Slot &) { stats.failed++; });
+                continue;
+            }
+
+            bool delivered = false;
+            bool done = waitForCallback(++sendSeq, delivered);
+            int64_t doneAt = esp_timer_get_time();
+            bool ok = done && delivered;
+            update(cmd.id, ok ? State::Sent : State::Failed, [&](Slot &slot) {
+                slot.doneAt = doneAt;
+                if (!done)
+                    stats.timeouts++;
+                if (!ok)
+                {
+                    stats.failed++;
+                    return;
+                }
+                stats.sent++;
+                uint32_t air = (uint32_t)(doneAt - sentAt);
+                stats.airUsTotal += air;
+                if (air > stats.airUsMax)
+                    stats.airUsMax = air;
+            });
+
+            ESP_LOGD(TAG, "#%lu %s event=%s value=%ld", (unsigned long)cmd.id, ok ? "sent" : "failed",
+                     EventToString(cmd.msg.event), (long)cmd.msg.value);
+        }
+    }
+
+    static uint32_t packCompletion(uint32_t seq, bool delivered)
+    {
+        return (seq << 1) | (delivered ? 1 : 0);
+    }
+
+    /// Waits up to SendTimeout for the callback numbered `seq`. Callbacks for
+    /// earlier frames that timed out may still arrive first; they are counted
+    /// and skipped.
+    bool waitForCallback(uint32_t seq, bool &delivered)
+    {
+        TickType_t start = xTaskGetTickCount();
+        while (true)
+        {
+            TickType_t waited = xTaskGetTickCount() - start;
+            if (waited >= SendTimeout || !sendDone.Take(SendTimeout - waited))
+                return false;
+
+            uint32_t c = completion.load(std::memory_order_acquire);
+            if ((c >> 1) == ((seq << 1) >> 1))
+            {
+                delivered = c & 1;
+                return true;
+            }
+            LOCK(mutex);
+            stats.lateCallbacks++;
+        }
+    }
+
+    /// Back-to-back sends can run out of ESP-NOW buffers; give the radio a tick.
+    esp_err_t send(const espnow_message_t &msg)
+    {
+        esp_err_t err = ESP_OK;
+        for (int attempt = 0; attempt < NoMemRetries; attempt++)
+        {
+            err = esp_now_send(dest, reinterpret_cast<const uint8_t *>(&msg), sizeof(msg));
+            if (err != ESP_ERR_ESPNOW_NO_MEM)
+                break;
+            vTaskDelay(1);
+        }
+        return err;
+    }
+
+    /// Update a receipt (if it has not been recycled) and the counters.
+    template <typename FUNC>
+    void update(uint32_t id, State state, FUNC fn)
+    {
+        LOCK(mutex);
+        Slot &slot = receipts[id % ReceiptDepth];
+        if (slot.id == id)
+        {
+            slot.state = state;
+            fn(slot);
+        }
+        else
+        {
+            Slot scratch;
+            fn(scratch);
+        }
+    }
+};
@@ -3,6 +3,7 @@
 #include "InitGuard.h"
 #include "FtpServer.h"
 #include "Task.h"
+#include <functional>
 
 
 
@@ -30,6 +31,12 @@ public:
         initGuard.SetReady();
     }
 
+    /// Set before init(); see FtpServer::setChangeHandler.
+    void SetChangeHandler(std::function<void(const char* path)> handler)
+    {
+        ftpServer.setChangeHandler(handler);
+    }
+
 private:
     InitGuard initGuard;
     FtpServer ftpServer {rootPath};
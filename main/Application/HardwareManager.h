@@ -4,6 +4,7 @@
 #include "WifiDriver.h"
 #include "EthernetDriver.h"
 #include "FatFsDriver.h"
+#include "PartitionMapDriver.h"
 #include "SystemInit.h"
 
 class HardwareManager {
@@ -23,6 +24,7 @@ public:
         wifiDriver.Init();
         ethernetDriver.Init();
         fatFsDriver.Init();
+        assetsPartition.Init();
 
         initGuard.SetReady();
     }
@@ -35,11 +37,16 @@ public:
         REQUIRE_READY(initGuard);
         return ethernetDriver; 
     }
+    const PartitionMapDriver& GetAssetsPartition() { 
+        REQUIRE_READY(initGuard);
+        return assetsPartition; 
+    }
 
 private:
     InitGuard initGuard;
     WifiDriver wifiDriver;
     EthernetDriver ethernetDriver;
     FatfsDriver fatFsDriver{"/fat", "fat"};
+    PartitionMapDriver assetsPartition{"assets"};
 
 };
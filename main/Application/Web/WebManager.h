@@ -2,8 +2,25 @@
 #include "WebServer.h"
 #include "FileController.h"
 #include "api/GuestSseEndpoint.h"
+#include "api/GuestWsEndpoint.h"
 #include "api/PostScoreEndpoint.h"
+#include "api/PostScoreBatchEndpoint.h"
+#include "api/TxStatusEndpoint.h"
+#include "api/MetricsEndpoint.h"
+#include "api/FileThroughputEndpoint.h"
+#include "core/PortRedirectEndpoint.h"
 
+/// Two httpd instances with separate socket budgets:
+///   realtime (port 8081)  API, SSE and WebSocket; never purges idle sockets
+///   assets   (port 80)    the UI's static files; purges the idlest keep-alive
+/// so a burst of asset requests cannot take sockets from live screens or
+/// delay API calls. The API is protected by the realtime budget: its sockets,
+/// its httpd task and its slowApi worker, none of which downloads use. Being
+/// another origin, it also has its own browser connection pool. The UI calls
+/// it cross-origin on 8081; CORS is open there and the preflight is cached
+/// (see WebServer::EnableCors). The assets server still redirects /api/* to
+/// 8081 with 307 for relative URLs. WebSocket clients connect to 8081
+/// directly.
 class WebManager {
 public:
     WebManager(EspNowManager& espNowManager)    
@@ -17,28 +34,55 @@ public:
     WebManager& operator=(WebManager&&) = delete;
 
     void init() {
-        server.start();
-        
-        server.registerHandler("/api/guests/events", HTTP_GET, guestSse);
-        server.registerHandler("/api/score", HTTP_POST, postScoreEndpoint);
-        
+        realtime.registerHandler("/api/guests/events", HTTP_GET, guestSse);
+        realtime.registerWebSocket("/api/guests/ws", guestWs);
+        realtime.registerHandler("/api/score", HTTP_POST, postScoreEndpoint);
+        realtime.registerHandler("/api/score/batch", HTTP_POST, postScoreBatchEndpoint, &slowApi);
+        realtime.registerHandler("/api/tx/stats", HTTP_GET, txStatusEndpoint);
+        realtime.registerHandler("/api/tx/{id}", HTTP_GET, txStatusEndpoint);
+        realtime.registerHandler("/api/metrics", HTTP_GET, metricsEndpoint);
+        realtime.registerHandler("/api/files/throughput", HTTP_GET, fileThroughputEndpoint);
+        realtime.EnableCors();
 
-        // These need last!
+        for (httpd_method_t method : {HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE})
+            assets.registerHandler("/api/*", method, apiRedirect);
         fileController.init();
-        server.EnableCors();
+        assets.EnableCors();
+
+        realtime.start();
+        assets.start();
     }
 
+    /// Serve the UI from a flashed asset bundle when the partition holds a
+    /// valid one. Call before init().
+    void UseAssetBundle(const PartitionMapDriver& partition) {
+        fileController.UseAssetBundle(partition);
+    }
 
+    void OnFileChanged(const char* path) {
+        fileController.OnFileChanged(path);
+    }
 
 private:
-    WebServer server;   
-    FileController fileController{server};
+    // Ports, sockets (LWIP_MAX_SOCKETS covers both plus FTP), priority, core, LRU purge
+    WebServer realtime {{"realtime", 8081, 32769, 12, tskIDLE_PRIORITY + 6, tskNO_AFFINITY, false}};
+    WebServer assets {{"assets", 80, 32768, 5, tskIDLE_PRIORITY + 4, 1, true}};
+    FileController fileController{assets};
 
     EspNowManager& espNowManager;
 
+    // Handlers that may block for a while (queue waits); must stay at 1 while
+    // PostScoreBatchEndpoint keeps its item table in the endpoint.
+    WebServer::AsyncClass slowApi {"slowApi", 1};
+
     GuestSseEndpoint guestSse {espNowManager};
+    GuestWsEndpoint guestWs {espNowManager};
     PostScoreEndpoint postScoreEndpoint {espNowManager};
-
+    PostScoreBatchEndpoint postScoreBatchEndpoint {espNowManager};
+    TxStatusEndpoint txStatusEndpoint {espNowManager};
+    MetricsEndpoint metricsEndpoint {&realtime, &assets};
+    FileThroughputEndpoint fileThroughputEndpoint {fileController.GetStreamer()};
+    PortRedirectEndpoint apiRedirect {8081};
 };
 
 
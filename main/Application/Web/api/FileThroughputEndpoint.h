@@ -0,0 +1,44 @@
+#pragma once
+#include "HttpEndpoint.h"
+#include "ResponseStream.h"
+#include "ResponseFormat.h"
+#include "FileGetEndpoint.h"
+
+/// GET /api/files/throughput  static file streaming rate per file-size class,
+/// so read-ahead settings can be compared on the device across page loads.
+/// `kBps` is bytes per millisecond of streaming, i.e. kilobytes per second.
+class FileThroughputEndpoint : public HttpEndpoint
+{
+public:
+    FileThroughputEndpoint(const FileGetEndpoint::Streamer &streamer)
+        : streamer(streamer)
+    {
+    }
+
+    esp_err_t handle(httpd_req_t *req) override
+    {
+        const auto *classes = streamer.GetSizeClasses();
+
+        ResponseFormat::Type format = ResponseFormat::Negotiate(req);
+        httpd_resp_set_type(req, ResponseFormat::ContentType(format));
+        ResponseStream stream(req);
+        ResponseFormat::WriteArray(format, stream, [&](auto &arr) {
+            for (size_t i = 0; i < FileGetEndpoint::Streamer::SizeClassCount; i++)
+            {
+                uint64_t bytes = classes[i].bytes.Load();
+                uint64_t micros = classes[i].micros.Load();
+                arr.withObject([&](auto &obj) {
+                    obj.field("maxSize", (uint64_t)classes[i].maxSize);
+                    obj.field("streams", (uint64_t)classes[i].streams.load(std::memory_order_relaxed));
+                    obj.field("bytes", bytes);
+                    obj.field("kBps", micros ? bytes * 1000 / micros : (uint64_t)0);
+                });
+            }
+        });
+        stream.close();
+        return ESP_OK;
+    }
+
+private:
+    const FileGetEndpoint::Streamer &streamer;
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include "EspNowMessage.h"
+#include "JsonStreamReader.h"
+#include "utils.h"
+#include <cstring>
+
+/// Guest command as sent by the UI:
+///   {"cmd":"score","mac":"AA:BB:CC:DD:EE:FF","score":3}
+///   {"cmd":"blink","mac":"AA:BB:CC:DD:EE:FF"}
+/// "cmd" defaults to "score", so a plain {"mac","score"} body is a command too.
+class GuestCommand
+{
+public:
+    /// Reads one command object into `msg`. Returns nullptr on success, else a
+    /// short reason. Bad values leave the reader usable; broken JSON does not.
+    static const char *Read(JsonStreamReader &json, espnow_message_t &msg)
+    {
+        char cmd[16] = "score";
+        char mac[18] = {0};
+        int32_t score = 0;
+        bool hasScore = false;
+        bool badType = false;
+        msg = {};
+
+        if (json.peekType() != JsonStreamReader::Type::Object)
+        {
+            json.skip();
+            return json.failed() ? "invalid json" : "not an object";
+        }
+
+        json.readObject([&](const char *key) {
+            if (strcmp(key, "cmd") == 0)
+                badType |= !readString(json, cmd, sizeof(cmd));
+            else if (strcmp(key, "mac") == 0)
+                badType |= !readString(json, mac, sizeof(mac));
+            else if (strcmp(key, "score") == 0)
+            {
+                if (json.peekType() == JsonStreamReader::Type::Number)
+                {
+                    hasScore = json.readIntIfFits(score);
+                    badType |= !hasScore;
+                }
+                else
+                    badType = true;
+            }
+        });
+
+        if (json.failed())
+            return "invalid json";
+        if (badType)
+            return "invalid field";
+
+        if (!MacUtils::FromString(mac, msg.destinationMac))
+            return "invalid mac";
+
+        if (strcmp(cmd, "score") == 0)
+        {
+            if (!hasScore)
+                return "missing score";
+            msg.event = ESPNOW_MESSAGE_EVENT_SCORE_UPDATE;
+            msg.value = score;
+        }
+        else if (strcmp(cmd, "blink") == 0)
+        {
+            msg.event = ESPNOW_MESSAGE_EVENT_BLINK;
+        }
+        else
+        {
+            return "unknown cmd";
+        }
+        return nullptr;
+    }
+
+private:
+    /// Non-string and over-long values are skipped (leaving the reader
+    /// intact) and reported.
+    static bool readString(JsonStreamReader &json, char *out, size_t outSize)
+    {
+        if (json.peekType() != JsonStreamReader::Type::String)
+            return false;
+        return json.readStringIfFits(out, outSize);
+    }
+};
@@ -0,0 +1,127 @@
+#pragma once
+#include "esp_http_server.h"
+#include "EspNowManager.h"
+#include "utils.h"
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+
+/// Per-client subscription for /api/guests/events, parsed once at connect:
+///   ?mac=AA:BB:CC:DD:EE:FF,11:22:33:44:55:66&event=button,score
+/// Missing parameters match everything.
+class GuestEventFilter
+{
+public:
+    static constexpr size_t MaxMacs = 8;
+
+    struct Tag
+    {
+        uint8_t mac[6] = {0};
+        espnow_message_event_t event = ESPNOW_MESSAGE_EVENT_BUTTON_PRESS;
+    };
+
+    bool Parse(const char *query)
+    {
+        macCount = 0;
+        eventMask = AllEvents;
+
+        char value[MaxMacs * 18 + 1];
+        esp_err_t err = httpd_query_key_value(query, "mac", value, sizeof(value));
+        if (err == ESP_OK)
+        {
+            if (!parseMacs(value))
+                return false;
+        }
+        else if (err != ESP_ERR_NOT_FOUND)
+        {
+            return false;
+        }
+
+        err = httpd_query_key_value(query, "event", value, sizeof(value));
+        if (err == ESP_OK)
+        {
+            if (!parseEvents(value))
+                return false;
+        }
+        else if (err != ESP_ERR_NOT_FOUND)
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Matches(const Tag &tag) const
+    {
+        // The event byte comes off the radio; unknown values match nothing
+        if ((uint8_t)tag.event >= EventCount || (eventMask & (1u << tag.event)) == 0)
+            return false;
+        if (macCount == 0)
+            return true;
+        for (size_t i = 0; i < macCount; i++)
+        {
+            if (memcmp(macs[i], tag.mac, 6) == 0)
+                return true;
+        }
+        return false;
+    }
+
+private:
+    static constexpr uint8_t EventCount = ESPNOW_MESSAGE_EVENT_BLINK + 1;
+    static constexpr uint32_t AllEvents = 0xFFFFFFFF;
+    static_assert(EventCount <= 32, "event mask holds one bit per event");
+
+    uint8_t macs[MaxMacs][6] = {};
+    uint8_t macCount = 0;
+    uint32_t eventMask = AllEvents;
+
+    bool parseMacs(char *list)
+    {
+        urlDecode(list);
+        char *save = nullptr;
+        for (char *tok = strtok_r(list, ",", &save); tok; tok = strtok_r(nullptr, ",", &save))
+        {
+            if (macCount == MaxMacs || !MacUtils::FromString(tok, macs[macCount]))
+                return false;
+            macCount++;
+        }
+        return macCount > 0;
+    }
+
+    bool parseEvents(char *list)
+    {
+        urlDecode(list);
+        eventMask = 0;
+        char *save = nullptr;
+        for (char *tok = strtok_r(list, ",", &save); tok; tok = strtok_r(nullptr, ",", &save))
+        {
+            uint8_t e = 0;
+            while (e < EventCount && strcmp(tok, EventToString((espnow_message_event_t)e)) != 0)
+                e++;
+            if (e == EventCount)
+                return false;
+            eventMask |= 1u << e;
+        }
+        return eventMask != 0;
+    }
+
+    /// In-place %XX decoding; the UI may encode ':' and ',' in the query.
+    static void urlDecode(char *s)
+    {
+        char *out = s;
+        while (*s)
+        {
+            if (s[0] == '%' && isxdigit((unsigned char)s[1]) && isxdigit((unsigned char)s[2]))
+            {
+                char hex[3] = {s[1], s[2], '\0'};
+                *out++ = (char)strtol(hex, nullptr, 16);
+                s += 3;
+            }
+            else
+            {
+                *out++ = *s++;
+            }
+        }
+        *out = '\0';
+    }
+};
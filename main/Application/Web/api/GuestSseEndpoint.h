@@ -1,17 +1,26 @@
 #pragma once
 #include "HttpSseEndpoint.h"
+#include "GuestEventFilter.h"
 #include "EspNowManager.h"
 #include "json.h"
 #include "utils.h"
+#include "StaticVector.h"
 
 
-class GuestSseEndpoint : public HttpSseEndpoint<8>
+class GuestSseEndpoint : public HttpSseEndpoint<8, 8, 256, 32, GuestEventFilter>
 {
     constexpr static const char* TAG = "GuestSseEndpoint";
+    constexpr static TickType_t KeepAliveTicks = pdMS_TO_TICKS(15000);
+    constexpr static TickType_t BatchWindowTicks = pdMS_TO_TICKS(20);
+    constexpr static size_t MaxPending = 16;
+    constexpr static bool CoalesceScores = true; // keep only the latest score per guest in a batch
 public:
     GuestSseEndpoint(EspNowManager& espNowManager)
-        : espNowManager(espNowManager)
+        : HttpSseEndpoint(FrameOverflowPolicy::Coalesce)
+        , subscriber(espNowManager.Subscribe("GuestSse"))
     {
+        assert(subscriber);
+
         // spawn background task
         task.Init("SSEPushTask", 5, 8192);
         task.SetHandler([this]() { runLoop(); });
@@ -20,22 +29,38 @@ public:
 
 protected:
     void OnConnect(Stream& s) override {
-        // I dont have anything to send here
-        
+        // Missed events are replayed by the base class from Last-Event-ID
     }
 
 private:
-    EspNowManager& espNowManager;
+    struct PendingEvent
+    {
+        uint8_t mac[6];
+        espnow_message_t message;
+    };
+
+    EspNowManager::Subscriber* subscriber;
     Task task;
+    StaticVector<PendingEvent, MaxPending> pending;
 
     void runLoop() {
+        TickType_t wait = KeepAliveTicks;
         while (true) {
-            EspNowManager::Packet pkt;
-            if (espNowManager.Read(pkt, pdMS_TO_TICKS(30000))) {
-                handlePackage(pkt);
+            auto handle = [this](const EspNowManager::Packet& pkt) { handlePackage(pkt); };
+            if (subscriber->Read(handle, wait)) {
+                // Gather whatever else arrives within the batch window
+                TickType_t start = xTaskGetTickCount();
+                while (!pending.full()) {
+                    TickType_t elapsed = xTaskGetTickCount() - start;
+                    if (elapsed >= BatchWindowTicks)
+                        break;
+                    subscriber->Read(handle, BatchWindowTicks - elapsed);
+                }
+                pushToAllClients();
             }
-            // handle keepalive + cleanup
-            SendKeepAlive();
+
+            // Keepalives only for clients that have been idle a full interval
+            wait = SendKeepAlive(KeepAliveTicks);
         }
     }
 
@@ -50,31 +75,62 @@ private:
         // Interpret packet as espnow_message_t
         const espnow_message_t *message = reinterpret_cast<const espnow_message_t *>(pkt.data);
 
+        if (CoalesceScores && message->event == ESPNOW_MESSAGE_EVENT_SCORE_UPDATE)
+        {
+            for (size_t i = 0; i < pending.size(); i++)
+            {
+                PendingEvent &p = pending[i];
+                if (p.message.event == ESPNOW_MESSAGE_EVENT_SCORE_UPDATE && memcmp(p.mac, pkt.mac, 6) == 0)
+                {
+                    p.message = *message;
+                    return;
+                }
+            }
+        }
 
-        
-        //ESP_LOGI(TAG, "Sent event=%s value=%ld name=%s", event_to_string(message->event), (long)message->value, message->name);
+        PendingEvent p;
+        memcpy(p.mac, pkt.mac, sizeof(p.mac));
+        p.message = *message;
+        pending.try_push_back(p);
+    }
 
-        // Push event to all connected SSE clients
-        pushToAllClients(pkt.mac, *message);
+    /// Score updates from the same guest supersede each other when a client
+    /// falls behind; button presses are never coalesced.
+    static uint16_t coalesceKey(const uint8_t *mac, const espnow_message_t &message)
+    {
+        if (message.event != ESPNOW_MESSAGE_EVENT_SCORE_UPDATE)
+            return 0;
+        uint16_t key = (uint16_t)((mac[4] << 8) | mac[5]);
+        return (key == 0 || key == KeepAliveKey) ? 1 : key;
     }
 
-    void pushToAllClients(const uint8_t *mac, const espnow_message_t &message)
+    /// Render each pending event once and publish them as one batch.
+    void pushToAllClients()
     {
-        ForEachClient([&](Stream &s) {
-            s.write("data: ", 6);
+        Event events[MaxPending];
+        size_t count = pending.size();
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const PendingEvent &p = pending[i];
             char macId[18];
-            MacUtils::ToString(mac, macId, sizeof(macId));
-            JsonObjectWriter::create(s, [&](JsonObjectWriter &obj) {
-                obj.field("mac", macId);
-                obj.field("event", EventToString(message.event));
-                obj.field("value", (int64_t)message.value);
-                obj.field("name", message.name);
+            MacUtils::ToString(p.mac, macId, sizeof(macId));
+
+            GuestEventFilter::Tag tag;
+            memcpy(tag.mac, p.mac, sizeof(tag.mac));
+            tag.event = p.message.event;
+
+            events[i] = RenderEvent(tag, coalesceKey(p.mac, p.message), [&](Stream &s) {
+                JsonObjectWriter::create(s, [&](JsonObjectWriter &obj) {
+                    obj.field("mac", macId);
+                    obj.field("event", EventToString(p.message.event));
+                    obj.field("value", (int64_t)p.message.value);
+                    obj.field("name", p.message.name);
+                });
             });
-            s.write("\n\n", 2);
-            s.flush();
-            return true; // keep client alive
-        });
+        }
+
+        PublishBatch(events, count);
+        pending.clear();
     }
 };
-
-
@@ -0,0 +1,145 @@
+#pragma once
+#include "HttpWsEndpoint.h"
+#include "GuestEventFilter.h"
+#include "GuestCommand.h"
+#include "EspNowManager.h"
+#include "BufferStream.h"
+#include "json.h"
+#include "cbor.h"
+#include "utils.h"
+#include <cstring>
+
+/// Binary downlink frame: the sender's MAC followed by the raw message.
+typedef struct __attribute__((packed))
+{
+    uint8_t mac[6];
+    espnow_message_t message;
+} guest_ws_event_t;
+
+/// Bidirectional guest channel on /api/guests/ws.
+/// Down: every received ESP-NOW event, as the same JSON object the SSE stream
+/// carries, as that object in CBOR with `?format=cbor`, or as a guest_ws_event_t
+/// with `?format=binary`. The mac/event filters of /api/guests/events apply.
+/// Up: commands forwarded to the guests, either as a raw espnow_message_t
+/// binary frame or as a GuestCommand text frame.
+/// Commands are not acknowledged; failures get an {"error":"..."} frame.
+class GuestWsEndpoint : public HttpWsEndpoint<4, 128, GuestEventFilter>
+{
+    constexpr static const char* TAG = "GuestWsEndpoint";
+
+public:
+    GuestWsEndpoint(EspNowManager& espNowManager)
+        : espNowManager(espNowManager)
+        , subscriber(espNowManager.Subscribe("GuestWs"))
+    {
+        assert(subscriber);
+
+        task.Init("WSPushTask", 5, 4096);
+        task.SetHandler([this]() { runLoop(); });
+        task.Run();
+    }
+
+protected:
+    void OnFrame(Client& client, const httpd_ws_frame_t& frame) override
+    {
+        espnow_message_t msg = {};
+        const char* error = frame.type == HTTPD_WS_TYPE_BINARY
+            ? parseBinary(frame, msg)
+            : parseText(frame, msg);
+
+        if (!error && !espNowManager.Submit(msg))
+            error = "queue full";
+
+        if (error)
+        {
+            char reply[64];
+            int len = snprintf(reply, sizeof(reply), "{\"error\":\"%s\"}", error);
+            Send(client, HTTPD_WS_TYPE_TEXT, reply, len);
+        }
+    }
+
+private:
+    EspNowManager& espNowManager;
+    EspNowManager::Subscriber* subscriber;
+    Task task;
+
+    void runLoop()
+    {
+        // Copy the packet out so the bus slot is released before any work
+        EspNowManager::Packet pkt;
+        auto copy = [&pkt](const EspNowManager::Packet& p) { pkt = p; };
+        while (true)
+        {
+            if (subscriber->Read(copy, portMAX_DELAY))
+                publish(pkt);
+        }
+    }
+
+    /// Render every encoding once and queue them for the matching clients.
+    void publish(const EspNowManager::Packet& pkt)
+    {
+        if (pkt.len < (int)sizeof(espnow_message_t))
+            return;
+
+        guest_ws_event_t binary;
+        memcpy(binary.mac, pkt.mac, sizeof(binary.mac));
+        memcpy(&binary.message, pkt.data, sizeof(binary.message));
+
+        char macId[18];
+        MacUtils::ToString(pkt.mac, macId, sizeof(macId));
+
+        auto fields = [&](auto& obj) {
+            obj.field("mac", macId);
+            obj.field("event", EventToString(binary.message.event));
+            obj.field("value", (int64_t)binary.message.value);
+            obj.field("name", binary.message.name);
+        };
+
+        char text[160];
+        BufferStream json(text, sizeof(text));
+        JsonObjectWriter::create(json, fields);
+
+        char packed[96];
+        BufferStream cbor(packed, sizeof(packed));
+        CborObjectWriter::create(cbor, fields);
+
+        if (json.Truncated() || cbor.Truncated())
+        {
+            ESP_LOGW(TAG, "Event from %s does not fit a frame", macId);
+            return;
+        }
+
+        GuestEventFilter::Tag tag;
+        memcpy(tag.mac, pkt.mac, sizeof(tag.mac));
+        tag.event = binary.message.event;
+
+        Payload payloads[FormatCount];
+        payloads[Text] = {json.Data(), json.Size()};
+        payloads[Binary] = {&binary, sizeof(binary)};
+        payloads[Cbor] = {cbor.Data(), cbor.Size()};
+        Broadcast(tag, payloads);
+    }
+
+    static bool isCommand(espnow_message_event_t event)
+    {
+        return event == ESPNOW_MESSAGE_EVENT_SCORE_UPDATE || event == ESPNOW_MESSAGE_EVENT_BLINK;
+    }
+
+    static const char* parseBinary(const httpd_ws_frame_t& frame, espnow_message_t& msg)
+    {
+        if (frame.len != sizeof(espnow_message_t))
+            return "bad frame size";
+        memcpy(&msg, frame.payload, sizeof(msg));
+        return isCommand(msg.event) ? nullptr : "unsupported event";
+    }
+
+    static const char* parseText(const httpd_ws_frame_t& frame, espnow_message_t& msg)
+    {
+        BufferStream in(frame.payload, frame.len, frame.len);
+        JsonStreamReader json(in);
+        const char* error = GuestCommand::Read(json, msg);
+        if (!error && !json.finish())
+            error = "invalid json";
+        return error;
+    }
+};
@@ -0,0 +1,187 @@
+#pragma once
+#include "HttpEndpoint.h"
+#include "ResponseStream.h"
+#include "ResponseFormat.h"
+#include "WebServer.h"
+#include <initializer_list>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/// GET /api/metrics  per-route request counters and latency histograms for
+/// every WebServer instance, labelled with the server name.
+/// Prometheus text exposition by default; JSON or CBOR when asked for with
+/// `?format=json|cbor` or an `Accept` header naming either type.
+class MetricsEndpoint : public HttpEndpoint
+{
+public:
+    MetricsEndpoint(std::initializer_list<const WebServer *> list)
+    {
+        for (const WebServer *s : list)
+        {
+            if (count < MaxServers)
+                servers[count++] = s;
+        }
+    }
+
+    esp_err_t handle(httpd_req_t *req) override
+    {
+        if (wantsStructured(req))
+            return sendStructured(req);
+        return sendPrometheus(req);
+    }
+
+private:
+    constexpr static const char *StatusLabels[RouteMetrics::StatusClassCount] = {
+        "none", "1xx", "2xx", "3xx", "4xx", "5xx"};
+
+    constexpr static size_t MaxServers = 2;
+
+    const WebServer *servers[MaxServers] = {};
+    size_t count = 0;
+
+    /// fn(server, route, method, metrics) across all servers
+    template <typename FUNC>
+    void forEachRoute(FUNC fn) const
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const char *name = servers[i]->GetName();
+            servers[i]->ForEachRoute([&](const char *route, const char *method, const RouteMetrics &m) {
+                fn(name, route, method, m);
+            });
+        }
+    }
+
+    static bool wantsStructured(httpd_req_t *req)
+    {
+        char query[64];
+        char value[8];
+        esp_err_t err = httpd_req_get_url_query_str(req, query, sizeof(query));
+        if ((err == ESP_OK || err == ESP_ERR_HTTPD_RESULT_TRUNC) &&
+            httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK)
+        {
+            return strcmp(value, "json") == 0 || strcmp(value, "cbor") == 0;
+        }
+
+        char accept[64];
+        err = httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept));
+        return (err == ESP_OK || err == ESP_ERR_HTTPD_RESULT_TRUNC) &&
+               (strstr(accept, "application/json") || strstr(accept, "application/cbor"));
+    }
+
+    esp_err_t sendStructured(httpd_req_t *req)
+    {
+        ResponseFormat::Type format = ResponseFormat::Negotiate(req);
+        httpd_resp_set_type(req, ResponseFormat::ContentType(format));
+        ResponseStream stream(req);
+        ResponseFormat::WriteObject(format, stream, [&](auto &root) {
+            root.withArray("routes", [&](auto &arr) {
+                forEachRoute([&](const char *name, const char *route, const char *method, const RouteMetrics &m) {
+                    arr.withObject([&](auto &obj) {
+                        obj.field("server", name);
+                        obj.field("route", route);
+                        obj.field("method", method);
+                        obj.field("requests", (uint64_t)load(m.requests));
+                        obj.field("inFlight", (uint64_t)load(m.inFlight));
+                        obj.field("bytesSent", (uint64_t)load(m.bytesSent));
+                        obj.field("latencyUsSum", m.latencyUsSum.Load());
+                        obj.withObject("status", [&](auto &status) {
+                            for (size_t i = 0; i < RouteMetrics::StatusClassCount; i++)
+                                status.field(StatusLabels[i], (uint64_t)load(m.status[i]));
+                        });
+                        // Per-bucket counts; the last bucket has no upper bound
+                        obj.withArray("latencyBucketsUs", [&](auto &bounds) {
+                            for (uint32_t bound : RouteMetrics::BucketBoundsUs)
+                                bounds.value((uint64_t)bound);
+                        });
+                        obj.withArray("latencyCounts", [&](auto &counts) {
+                            for (size_t i = 0; i < RouteMetrics::BucketCount; i++)
+                                counts.value((uint64_t)load(m.buckets[i]));
+                        });
+                    });
+                });
+            });
+        });
+        stream.close();
+        return ESP_OK;
+    }
+
+    esp_err_t sendPrometheus(httpd_req_t *req)
+    {
+        httpd_resp_set_type(req, "text/plain; version=0.0.4");
+        ResponseStream stream(req);
+
+        print(stream, "# HELP http_requests_total Requests handled, by status class.\n"
+                      "# TYPE http_requests_total counter\n");
+        forEachRoute([&](const char *name, const char *route, const char *method, const RouteMetrics &m) {
+            for (size_t i = 0; i < RouteMetrics::StatusClassCount; i++)
+            {
+                uint32_t n = load(m.status[i]);
+                if (n)
+                    print(stream, "http_requests_total{server=\"%s\",route=\"%s\",method=\"%s\",status=\"%s\"} %u\n",
+                          name, route, method, StatusLabels[i], (unsigned)n);
+            }
+        });
+
+        print(stream, "# HELP http_requests_in_flight Requests currently being handled.\n"
+                      "# TYPE http_requests_in_flight gauge\n");
+        forEachRoute([&](const char *name, const char *route, const char *method, const RouteMetrics &m) {
+            print(stream, "http_requests_in_flight{server=\"%s\",route=\"%s\",method=\"%s\"} %u\n",
+                  name, route, method, (unsigned)load(m.inFlight));
+        });
+
+        print(stream, "# HELP http_response_bytes_total Bytes sent, headers included.\n"
+                      "# TYPE http_response_bytes_total counter\n");
+        forEachRoute([&](const char *name, const char *route, const char *method, const RouteMetrics &m) {
+            print(stream, "http_response_bytes_total{server=\"%s\",route=\"%s\",method=\"%s\"} %u\n",
+                  name, route, method, (unsigned)load(m.bytesSent));
+        });
+
+        print(stream, "# HELP http_request_duration_seconds Time spent in the handler.\n"
+                      "# TYPE http_request_duration_seconds histogram\n");
+        forEachRoute([&](const char *name, const char *route, const char *method, const RouteMetrics &m) {
+            uint32_t cumulative = 0;
+            for (size_t i = 0; i < RouteMetrics::BucketCount; i++)
+            {
+                cumulative += load(m.buckets[i]);
+                char le[16];
+                if (i < RouteMetrics::BucketCount - 1)
+                {
+                    uint32_t us = RouteMetrics::BucketBoundsUs[i];
+                    snprintf(le, sizeof(le), "%u.%06u", (unsigned)(us / 1000000), (unsigned)(us % 1000000));
+                }
+                else
+                {
+                    strcpy(le, "+Inf");
+                }
+                print(stream, "http_request_duration_seconds_bucket{server=\"%s\",route=\"%s\",method=\"%s\",le=\"%s\"} %u\n",
+                      name, route, method, le, (unsigned)cumulative);
+            }
+            uint64_t sumUs = m.latencyUsSum.Load();
+            print(stream, "http_request_duration_seconds_sum{server=\"%s\",route=\"%s\",method=\"%s\"} %llu.%06u\n",
+                  name, route, method, (unsigned long long)(sumUs / 1000000), (unsigned)(sumUs % 1000000));
+            print(stream, "http_request_duration_seconds_count{server=\"%s\",route=\"%s\",method=\"%s\"} %u\n",
+                  name, route, method, (unsigned)cumulative);
+        });
+
+        stream.close();
+        return ESP_OK;
+    }
+
+    static uint32_t load(const std::atomic<uint32_t> &counter)
+    {
+        return counter.load(std::memory_order_relaxed);
+    }
+
+    static void print(Stream &stream, const char *fmt, ...)
+    {
+        char line[192];
+        va_list args;
+        va_start(args, fmt);
+        int len = vsnprintf(line, sizeof(line), fmt, args);
+        va_end(args);
+        if (len > 0)
+            stream.write(line, (size_t)len < sizeof(line) ? (size_t)len : sizeof(line) - 1);
+    }
+};
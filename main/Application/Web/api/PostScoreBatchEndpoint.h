@@ -0,0 +1,109 @@
+#pragma once
+#include "HttpEndpoint.h"
+#include "ResponseStream.h"
+#include "RequestStream.h"
+#include "GuestCommand.h"
+#include "EspNowManager.h"
+#include "ResponseFormat.h"
+#include "esp_log.h"
+
+/// POST /api/score/batch with a JSON array of GuestCommand objects.
+/// The whole body is validated in one streaming pass before anything is sent;
+/// valid items are then queued for the ESP-NOW task back to back. The reply is
+/// 202 with one result per item, in order:
+///   [{"status":"queued","id":17},{"status":"error","error":"invalid mac"}]
+class PostScoreBatchEndpoint : public HttpEndpoint
+{
+    constexpr static const char *TAG = "PostScoreBatchEndpoint";
+    constexpr static size_t MaxItems = 64;
+    constexpr static TickType_t SubmitTimeout = pdMS_TO_TICKS(50);
+
+public:
+    PostScoreBatchEndpoint(EspNowManager &espNowManager)
+        : espNowManager(espNowManager)
+    {
+    }
+
+    esp_err_t handle(httpd_req_t *req) override
+    {
+        RequestStream body(req);
+        JsonStreamReader json(body);
+
+        // Registered in an async class of limit 1, so requests never overlap
+        // and the item table can live in the endpoint instead of on the stack.
+        count = 0;
+        bool tooMany = false;
+        bool isArray = json.peekType() == JsonStreamReader::Type::Array;
+        json.readArray([&](size_t) {
+            if (count == MaxItems)
+            {
+                tooMany = true;
+                json.fail();
+                return;
+            }
+            Item &item = items[count++];
+            item.error = GuestCommand::Read(json, item.msg);
+        });
+
+        if (body.Failed())
+        {
+            ESP_LOGE(TAG, "Failed to receive POST data");
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to receive data");
+            return ESP_FAIL;
+        }
+        if (tooMany)
+        {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Too many items");
+            return ESP_FAIL;
+        }
+        if (!isArray || !json.finish())
+        {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+            return ESP_FAIL;
+        }
+
+        size_t queued = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            Item &item = items[i];
+            item.id = item.error ? 0 : espNowManager.Submit(item.msg, SubmitTimeout);
+            if (!item.error && item.id == 0)
+                item.error = "queue full";
+            if (!item.error)
+                queued++;
+        }
+        ESP_LOGI(TAG, "Queued %u of %u commands", (unsigned)queued, (unsigned)count);
+
+        ResponseFormat::Type format = ResponseFormat::Negotiate(req);
+        httpd_resp_set_status(req, "202 Accepted");
+        httpd_resp_set_type(req, ResponseFormat::ContentType(format));
+        ResponseStream stream(req);
+        ResponseFormat::WriteArray(format, stream, [&](auto &arr) {
+            for (size_t i = 0; i < count; i++)
+            {
+                arr.withObject([&](auto &obj) {
+                    obj.field("status", items[i].error ? "error" : "queued");
+                    if (items[i].error)
+                        obj.field("error", items[i].error);
+                    else
+                        obj.field("id", (uint64_t)items[i].id);
+                });
+            }
+        });
+        stream.close();
+
+        return ESP_OK;
+    }
+
+private:
+    struct Item
+    {
+        espnow_message_t msg;
+        const char *error;
+        uint32_t id;
+    };
+
+    EspNowManager &espNowManager;
+    Item items[MaxItems];
+    size_t count = 0;
+};
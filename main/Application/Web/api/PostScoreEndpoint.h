@@ -1,8 +1,10 @@
 #pragma once
 #include "HttpEndpoint.h"
 #include "ResponseStream.h"
+#include "RequestStream.h"
+#include "ResponseFormat.h"
+#include "JsonStreamReader.h"
 #include "esp_log.h"
-#include "cJSON.h"
 #include <cstring>
 #include <array>
 #include "EspNowManager.h"
@@ -19,26 +21,39 @@ public:
     {
         static constexpr const char *TAG = "PostScoreEndpoint";
 
-        char body[256] = {0};
-        if (!receiveBody(req, body, sizeof(body)))
+        RequestStream body(req);
+        int32_t score = 0;
+        char mac[18] = {0};
+        bool ok = parseJson(body, score, mac, sizeof(mac));
+        if (body.Failed())
         {
+            ESP_LOGE(TAG, "Failed to receive POST data");
             httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to receive data");
             return ESP_FAIL;
         }
-
-        int score = 0;
-        char mac[18] = {0};
-        if (!parseJson(body, score, mac, sizeof(mac)))
+        if (!ok)
         {
             httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
             return ESP_FAIL;
         }
 
-        handleData(score, mac);
+        uint32_t id = handleData(score, mac);
+        if (id == 0)
+        {
+            httpd_resp_set_status(req, "503 Service Unavailable");
+            httpd_resp_set_hdr(req, "Retry-After", "1");
+            return httpd_resp_send(req, nullptr, 0);
+        }
 
+        // Accepted, not yet sent: the id can be polled at /api/tx/<id>
+        ResponseFormat::Type format = ResponseFormat::Negotiate(req);
+        httpd_resp_set_status(req, "202 Accepted");
+        httpd_resp_set_type(req, ResponseFormat::ContentType(format));
         ResponseStream stream(req);
-        const char *response = "{\"status\":\"ok\"}";
-        stream.write(response, strlen(response));
+        ResponseFormat::WriteObject(format, stream, [&](auto &obj) {
+            obj.field("status", "queued");
+            obj.field("id", (uint64_t)id);
+        });
         stream.close();
 
         return ESP_OK;
@@ -46,50 +61,31 @@ public:
 
 private:
     EspNowManager& espNowManager;
-    bool receiveBody(httpd_req_t *req, char *out, size_t maxLen)
-    {
-        int total_len = req->content_len;
-        int received = 0;
-        while (received < total_len && received < (int)(maxLen - 1))
-        {
-            int ret = httpd_req_recv(req, out + received, maxLen - 1 - received);
-            if (ret <= 0)
-            {
-                ESP_LOGE("PostScoreEndpoint", "Failed to receive POST data");
-                return false;
-            }
-            received += ret;
-        }
-        out[received] = '\0';
-        return true;
-    }
-
-    bool parseJson(const char *json, int &score, char *mac, size_t macLen)
+    /// Binds {"score": int, "mac": string} straight from the socket; other
+    /// members are skipped, so the body size is not limited.
+    bool parseJson(Stream &body, int32_t &score, char *mac, size_t macLen)
     {
-        cJSON *root = cJSON_Parse(json);
-        if (!root)
+        bool hasScore = false;
+        bool hasMac = false;
+        JsonStreamReader json(body);
+        json.readObject([&](const char *key) {
+            if (strcmp(key, "score") == 0)
+                hasScore = json.readInt(score);
+            else if (strcmp(key, "mac") == 0)
+                hasMac = json.readString(mac, macLen);
+        });
+
+        if (!json.finish())
         {
             ESP_LOGE("PostScoreEndpoint", "JSON parse error");
             return false;
         }
-
-        cJSON *scoreItem = cJSON_GetObjectItem(root, "score");
-        cJSON *macItem = cJSON_GetObjectItem(root, "mac");
-
-        bool ok = cJSON_IsNumber(scoreItem) && cJSON_IsString(macItem);
-        if (ok)
-        {
-            score = scoreItem->valueint;
-            strncpy(mac, macItem->valuestring, macLen - 1);
-            mac[macLen - 1] = '\0';
-        }
-        else
+        if (!hasScore || !hasMac)
         {
             ESP_LOGE("PostScoreEndpoint", "Missing or invalid JSON fields");
+            return false;
         }
-
-        cJSON_Delete(root);
-        return ok;
+        return true;
     }
 
     /// Base64 decoder (no dynamic memory)
@@ -136,7 +132,7 @@ private:
         return true;
     }
 
-    void handleData(int score, const char *mac)
+    uint32_t handleData(int32_t score, const char *mac)
     {
         uint8_t macBytes[6] = {0};
         MacUtils::FromString(mac, macBytes);
@@ -145,6 +141,6 @@ private:
         msg.event = ESPNOW_MESSAGE_EVENT_SCORE_UPDATE;
         msg.value = score;
         memcpy(msg.destinationMac, macBytes, 6);
-        espNowManager.Send(msg);
+        return espNowManager.Submit(msg);
     }
 };
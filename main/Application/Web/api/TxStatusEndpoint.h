@@ -0,0 +1,81 @@
+#pragma once
+#include "HttpEndpoint.h"
+#include "ResponseStream.h"
+#include "EspNowManager.h"
+#include "ResponseFormat.h"
+#include <cstdlib>
+#include <cstring>
+
+/// GET /api/tx/<id>   receipt of a queued command (404 once recycled)
+/// GET /api/tx/stats  TX counters and latencies
+class TxStatusEndpoint : public HttpEndpoint
+{
+public:
+    TxStatusEndpoint(EspNowManager &espNowManager)
+        : espNowManager(espNowManager)
+    {
+    }
+
+    esp_err_t handle(httpd_req_t *req) override
+    {
+        return handle(req, RouteParams());
+    }
+
+    /// Registered for both routes; only /api/tx/{id} carries an id
+    esp_err_t handle(httpd_req_t *req, const RouteParams &params) override
+    {
+        if (params.count == 0)
+            return sendStats(req);
+
+        char arg[12];
+        char *end = arg;
+        unsigned long id = 0;
+        if (params.Get("id", arg, sizeof(arg)))
+            id = strtoul(arg, &end, 10);
+        EspNowTransmitter::Receipt receipt;
+        if (end == arg || *end != '\0' || !espNowManager.GetReceipt((uint32_t)id, receipt))
+        {
+            httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown command id");
+            return ESP_FAIL;
+        }
+
+        ResponseFormat::Type format = ResponseFormat::Negotiate(req);
+        httpd_resp_set_type(req, ResponseFormat::ContentType(format));
+        ResponseStream stream(req);
+        ResponseFormat::WriteObject(format, stream, [&](auto &obj) {
+            obj.field("id", (uint64_t)receipt.id);
+            obj.field("state", EspNowTransmitter::StateToString(receipt.state));
+            obj.field("queueUs", (uint64_t)receipt.queueUs);
+            obj.field("airUs", (uint64_t)receipt.airUs);
+        });
+        stream.close();
+        return ESP_OK;
+    }
+
+private:
+    EspNowManager &espNowManager;
+
+    esp_err_t sendStats(httpd_req_t *req)
+    {
+        EspNowTransmitter::Stats s = espNowManager.GetTxStats();
+        uint32_t finished = s.sent + s.failed;
+
+        ResponseFormat::Type format = ResponseFormat::Negotiate(req);
+        httpd_resp_set_type(req, ResponseFormat::ContentType(format));
+        ResponseStream stream(req);
+        ResponseFormat::WriteObject(format, stream, [&](auto &obj) {
+            obj.field("submitted", (uint64_t)s.submitted);
+            obj.field("rejected", (uint64_t)s.rejected);
+            obj.field("sent", (uint64_t)s.sent);
+            obj.field("failed", (uint64_t)s.failed);
+            obj.field("timeouts", (uint64_t)s.timeouts);
+            obj.field("lateCallbacks", (uint64_t)s.lateCallbacks);
+            obj.field("queueUsAvg", (uint64_t)(finished ? s.queueUsTotal / finished : 0));
+            obj.field("queueUsMax", (uint64_t)s.queueUsMax);
+            obj.field("airUsAvg", (uint64_t)(s.sent ? s.airUsTotal / s.sent : 0));
+            obj.field("airUsMax", (uint64_t)s.airUsMax);
+        });
+        stream.close();
+        return ESP_OK;
+    }
+};
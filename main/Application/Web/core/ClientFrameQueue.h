@@ -0,0 +1,157 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "SharedFrame.h"
+
+/// What to do when a client's outbound queue is full.
+enum class FrameOverflowPolicy : uint8_t
+{
+    DropOldest, // discard the oldest frame that has not started sending
+    Coalesce,   // overwrite a pending frame with the same key, else drop oldest
+    Evict,      // disconnect the client
+};
+
+/// Bounded ring of outbound frames for one SSE or WebSocket client.
+/// Slots hold references to shared frames, so queueing never copies payload.
+/// The head frame may be partially sent; it is never dropped or overwritten,
+/// so the bytes on the socket always stay frame-aligned.
+template <size_t Depth>
+class ClientFrameQueue
+{
+    static_assert(Depth >= 2, "ClientFrameQueue needs room for an in-flight and a pending frame");
+
+public:
+    enum class PushResult
+    {
+        Queued,
+        Coalesced,
+        DroppedOldest,
+        Full,
+    };
+
+    struct Stats
+    {
+        uint32_t enqueued = 0;
+        uint32_t sent = 0;
+        uint32_t dropped = 0;
+        uint32_t coalesced = 0;
+        uint16_t depth = 0;
+        uint16_t highWater = 0;
+    };
+
+    bool empty() const { return count == 0; }
+    bool full() const { return count == Depth; }
+    size_t size() const { return count; }
+    const Stats &stats() const { return counters; }
+
+    PushResult push(const SharedFrameRef &frame, FrameOverflowPolicy policy)
+    {
+        PushResult result = PushResult::Queued;
+        if (count == Depth)
+        {
+            if (policy == FrameOverflowPolicy::Evict)
+                return PushResult::Full;
+
+            if (policy == FrameOverflowPolicy::Coalesce && frame->Key() != 0)
+            {
+                if (SharedFrameRef *f = findPending(frame->Key()))
+                {
+                    *f = frame;
+                    counters.coalesced++;
+                    return PushResult::Coalesced;
+                }
+            }
+
+            if (!dropOldestPending())
+                return PushResult::Full;
+            counters.dropped++;
+            result = PushResult::DroppedOldest;
+        }
+
+        frames[(head + count) % Depth] = frame;
+        count++;
+        counters.enqueued++;
+        updateDepth();
+        return result;
+    }
+
+    /// Unsent bytes of the head frame.
+    const char *pendingData() const { return frames[head]->Data() + headOffset; }
+    size_t pendingLen() const { return count ? frames[head]->Size() - headOffset : 0; }
+
+    /// Mark `n` bytes of the head frame as sent.
+    void consume(size_t n)
+    {
+        headOffset += n;
+        if (headOffset < frames[head]->Size())
+            return;
+
+        frames[head].reset();
+        head = (head + 1) % Depth;
+        headOffset = 0;
+        count--;
+        counters.sent++;
+        updateDepth();
+    }
+
+    void clear()
+    {
+        for (auto &f : frames)
+            f.reset();
+        head = 0;
+        count = 0;
+        headOffset = 0;
+        counters = Stats{};
+    }
+
+private:
+    SharedFrameRef frames[Depth];
+    size_t head = 0;
+    size_t count = 0;
+    size_t headOffset = 0;
+    Stats counters;
+
+    SharedFrameRef *findPending(uint16_t key)
+    {
+        for (size_t i = headOffset ? 1 : 0; i < count; i++)
+        {
+            SharedFrameRef &f = frames[(head + i) % Depth];
+            if (f->Key() == key)
+                return &f;
+        }
+        return nullptr;
+    }
+
+    bool dropOldestPending()
+    {
+        if (count == 0)
+            return false;
+
+        if (headOffset == 0)
+        {
+            frames[head].reset();
+            head = (head + 1) % Depth;
+            count--;
+            return true;
+        }
+
+        if (count < 2)
+            return false;
+
+        // Head is in flight: move it onto the slot of the oldest pending frame.
+        size_t next = (head + 1) % Depth;
+        frames[next] = std::move(frames[head]);
+        frames[head].reset();
+        head = next;
+        count--;
+        return true;
+    }
+
+    void updateDepth()
+    {
+        counters.depth = static_cast<uint16_t>(count);
+        if (counters.depth > counters.highWater)
+            counters.highWater = counters.depth;
+    }
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include "esp_err.h"
 #include "esp_http_server.h"
+#include "RouteParams.h"
 
 class HttpEndpoint {
 public:
@@ -13,4 +14,8 @@ public:
     HttpEndpoint& operator=(HttpEndpoint&&) = delete;
 
     virtual esp_err_t handle(httpd_req_t* req) = 0;
+
+    /// Entry point used by the router. Endpoints with path parameters
+    /// override this; the rest never see the parameters.
+    virtual esp_err_t handle(httpd_req_t* req, const RouteParams& params) { return handle(req); }
 };
@@ -1,49 +1,113 @@
 #pragma once
 #include "HttpEndpoint.h"
 #include "Mutex.h"
+#include "Semaphore.h"
+#include "Task.h"
 #include "Stream.h"
+#include "ClientFrameQueue.h"
+#include "SharedFrame.h"
 #include "esp_http_server.h"
 #include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
 
 class HttpSseEndpointBase {
-protected:
-    struct ClientSlot {
-        httpd_handle_t server = nullptr;
+public:
+    struct ClientStats {
         int sockfd = -1;
-        bool active = false;
+        uint32_t enqueued = 0;
+        uint32_t sent = 0;
+        uint32_t dropped = 0;
+        uint32_t coalesced = 0;
+        uint16_t depth = 0;
+        uint16_t highWater = 0;
     };
 
-    class SocketStream : public Stream {
-    public:
-        SocketStream(httpd_handle_t server, int sockfd)
-            : server(server), sockfd(sockfd) {}
+    /// Fan-out cost counters, totalled over the endpoint's lifetime.
+    struct FanoutStats {
+        uint32_t frames = 0;         // frames assembled from rendered events
+        uint32_t bytesFormatted = 0; // event bytes rendered (once per event)
+        uint32_t deliveries = 0;     // frames queued to a client
+        uint32_t sendCalls = 0;      // socket send calls made by the writer
+    };
 
-        size_t write(const void* data, size_t len) override {
-            if (!server || sockfd < 0) return 0;
-            int sent = httpd_socket_send(server, sockfd, (const char*) data, len, 0);
-            return sent < 0 ? 0 : sent;
-        }
+    /// Upper bound on events folded into one SSE frame.
+    static constexpr size_t MaxBatchEvents = 32;
 
-        size_t read(void* buffer, size_t len) override {
-            if (sockfd < 0) return 0;
-            int r = ::recv(sockfd, buffer, len, MSG_DONTWAIT);
-            return (r <= 0) ? 0 : r;
-        }
-
-        void flush() override {}
+protected:
+    /// Key reserved for keepalive comments, so they coalesce with each other.
+    static constexpr uint16_t KeepAliveKey = 0xFFFF;
+};
 
-    private:
-        httpd_handle_t server;
-        int sockfd;
-    };
+/// Default subscription filter: every client receives every event.
+struct SseAcceptAll {
+    struct Tag {};
+    bool Parse(const char* /*query*/) { return true; }
+    bool Matches(const Tag& /*tag*/) const { return true; }
 };
 
-template<size_t MaxClients>
+/// Server-sent events endpoint.
+/// Every client owns a bounded queue of shared frames; a writer task drains
+/// the queues with non-blocking sends, so one slow client never stalls the others.
+/// Events are rendered once, without SSE framing, and kept in a replay ring
+/// under increasing ids, so a client reconnecting with Last-Event-ID catches
+/// up. A batch of events goes out as a single frame holding a JSON array.
+/// Each client's Filter is parsed once from the query string at connect and
+/// checked against an event's Filter::Tag before the frame is queued for it.
+template<size_t MaxClients, size_t QueueDepth = 8, size_t MaxFrameSize = 256, size_t ReplayDepth = 32,
+         typename Filter = SseAcceptAll>
 class HttpSseEndpoint : public HttpEndpoint, protected HttpSseEndpointBase {
+    using Queue = ClientFrameQueue<QueueDepth>;
+    using Tag = typename Filter::Tag;
+
+    enum class SlotState : uint8_t {
+        Free,
+        Connecting, // reserved while the response headers go out
+        Active,
+        Closing,    // evicted, waiting for httpd to close the session
+    };
+
+    struct ClientSlot {
+        HttpSseEndpoint* owner = nullptr;
+        httpd_handle_t server = nullptr;
+        int sockfd = -1;
+        SlotState state = SlotState::Free;
+        uint32_t replayFrom = 0; // next event id to replay, 0 when live
+        TickType_t lastQueued = 0; // tick of the last frame queued, for keepalives
+        Filter filter;
+        Queue queue;
+    };
+
+    struct ReplayEntry {
+        uint32_t id = 0;
+        Tag tag;
+        SharedFrameRef body;
+    };
+
 public:
-    HttpSseEndpoint() {}
+    /// One rendered event: a JSON value plus the tag clients filter on.
+    struct Event {
+        Tag tag;
+        SharedFrameRef body;
+    };
+
+    explicit HttpSseEndpoint(FrameOverflowPolicy policy = FrameOverflowPolicy::DropOldest)
+        : policy(policy)
+    {
+        const char* msg = ": keepalive\n\n";
+        SharedFrameBuilder builder(strlen(msg), KeepAliveKey);
+        builder.write(msg, strlen(msg));
+        keepAliveFrame = builder.Finish();
+
+        for (auto& c : clients)
+            c.owner = this;
+
+        writerTask.Init("SSEWriter", 5, 4096);
+        writerTask.SetHandler([this]() { writerLoop(); });
+        writerTask.Run();
+    }
 
     esp_err_t handle(httpd_req_t* req) override {
         int fd = httpd_req_to_sockfd(req);
@@ -52,6 +116,22 @@ public:
             return ESP_FAIL;
         }
 
+        Filter filter;
+        if (!readFilter(req, filter)) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid subscription filter");
+            return ESP_FAIL;
+        }
+
+        ClientSlot* slot = reserveSlot(req->handle, fd, filter);
+        if (!slot) {
+            ESP_LOGW(TAG, "All %d SSE slots in use, rejecting fd=%d", (int)MaxClients, fd);
+            char retryAfter[8];
+            snprintf(retryAfter, sizeof(retryAfter), "%d", RetryAfterSeconds);
+            httpd_resp_set_status(req, "503 Service Unavailable");
+            httpd_resp_set_hdr(req, "Retry-After", retryAfter);
+            return httpd_resp_send(req, nullptr, 0);
+        }
+
         const char* hdr =
             "HTTP/1.1 200 OK\r\n"
             "Access-Control-Allow-Origin: *\r\n"
@@ -65,66 +145,481 @@ public:
 
         if (httpd_socket_send(req->handle, fd, hdr, strlen(hdr), 0) < 0) {
             ESP_LOGE(TAG, "Failed to send SSE headers");
+            LOCK(clientMutex);
+            release(*slot);
             return ESP_FAIL;
         }
 
-        LOCK(clientMutex);
-        for (size_t i = 0; i < MaxClients; i++) {
-            if (!clients[i].active) {
-                clients[i].server = req->handle;
-                clients[i].sockfd = fd;
-                clients[i].active = true;
-                ESP_LOGI(TAG, "SSE client %d connected (fd=%d)", (int)i, fd);
+        // Tie the slot to the httpd session: when the socket closes for any
+        // reason, httpd frees the session context and the slot is released.
+        req->sess_ctx = slot;
+        req->free_ctx = &HttpSseEndpoint::onSessionClosed;
 
-                SocketStream stream(clients[i].server, clients[i].sockfd);
-                OnConnect(stream);  // hook for derived
+        uint32_t lastEventId = 0;
+        bool resume = readLastEventId(req, lastEventId);
 
-                break;
+        {
+            LOCK(clientMutex);
+            slot->state = SlotState::Active;
+            ESP_LOGI(TAG, "SSE client %d connected (fd=%d)", (int)(slot - clients), fd);
+
+            QueueStream stream(*this, *slot);
+            OnConnect(stream);  // hook for derived
+            stream.flush();
+            if (stream.evicted()) {
+                cleanup(*slot);
+            } else if (resume) {
+                slot->replayFrom = replayStart(lastEventId);
             }
         }
 
+        writerWake.Give();
         return ESP_OK;
     }
 
+    /// Render one event body (a JSON value, no SSE framing) into a shared
+    /// buffer. `key` lets a newer event replace this one in a full queue.
     template<typename FUNC>
-    void ForEachClient(FUNC&& func) {
-        LOCK(clientMutex);
-        for (size_t i = 0; i < MaxClients; i++) {
-            if (clients[i].active) {
-                SocketStream stream(clients[i].server, clients[i].sockfd);
-                if (func(stream) == false) {
+    static Event RenderEvent(const Tag& tag, uint16_t key, FUNC&& render) {
+        SharedFrameBuilder body(MaxFrameSize, key);
+        render(static_cast<Stream&>(body));
+        if (body.Truncated())
+            ESP_LOGW(TAG, "Event exceeds %d bytes, dropped", (int)MaxFrameSize);
+        return Event{tag, body.Finish()};
+    }
+
+    /// Render and publish a single event.
+    template<typename FUNC>
+    void BroadcastEvent(const Tag& tag, uint16_t key, FUNC&& render) {
+        Event event = RenderEvent(tag, key, render);
+        PublishBatch(&event, 1);
+    }
+
+    /// Give every event an id, record it for replay, and queue one frame per
+    /// client holding the events its filter accepts. Clients that accept the
+    /// same events share the frame. A frame carries the id of its last event.
+    void PublishBatch(const Event* events, size_t count) {
+        while (count > 0) {
+            size_t n = count < MaxBatchEvents ? count : MaxBatchEvents;
+            publishChunk(events, n);
+            events += n;
+            count -= n;
+        }
+        writerWake.Give();
+    }
+
+    /// Queue one pre-rendered frame for every client, ignoring filters.
+    void Broadcast(const SharedFrameRef& frame) {
+        if (!frame)
+            return;
+        {
+            LOCK(clientMutex);
+            for (size_t i = 0; i < MaxClients; i++) {
+                if (clients[i].state == SlotState::Active && !enqueue(clients[i], frame))
                     cleanup(clients[i]);
+            }
+        }
+        writerWake.Give();
+    }
+
+    /// Queue a per-client frame for every client. Frames are rendered per
+    /// client and queued on flush(); prefer Broadcast() for shared content.
+    template<typename FUNC>
+    void ForEachClient(FUNC&& func) {
+        {
+            LOCK(clientMutex);
+            for (size_t i = 0; i < MaxClients; i++) {
+                if (clients[i].state == SlotState::Active) {
+                    QueueStream stream(*this, clients[i]);
+                    bool keep = func(stream);
+                    stream.flush();
+                    if (!keep || stream.evicted()) {
+                        cleanup(clients[i]);
+                    }
                 }
             }
         }
+        writerWake.Give();
     }
 
-    /// Periodic keepalive tick
-    void SendKeepAlive() {
-        static const char* msg = ": keepalive\n\n";
-        ForEachClient([&](Stream& s) {
-            if (s.write(msg, strlen(msg)) == 0) {
-                return false; // drop client if failed
+    /// Queue a keepalive comment for every client that has had nothing
+    /// queued for `idle` ticks. Returns the ticks until the next one is due,
+    /// so the caller can sleep until then.
+    TickType_t SendKeepAlive(TickType_t idle) {
+        TickType_t next = idle;
+        bool queued = false;
+        {
+            LOCK(clientMutex);
+            TickType_t now = xTaskGetTickCount();
+            for (size_t i = 0; i < MaxClients; i++) {
+                ClientSlot& c = clients[i];
+                if (c.state != SlotState::Active)
+                    continue;
+                TickType_t quiet = now - c.lastQueued;
+                if (quiet < idle) {
+                    next = idle - quiet < next ? idle - quiet : next;
+                } else if (c.queue.empty() && keepAliveFrame) {
+                    enqueue(c, keepAliveFrame);
+                    queued = true;
+                }
             }
-            s.flush();
-            return true;
-        });
+        }
+        if (queued)
+            writerWake.Give();
+        return next;
+    }
+
+    bool GetClientStats(size_t index, ClientStats& out) {
+        LOCK(clientMutex);
+        if (index >= MaxClients || clients[index].state != SlotState::Active)
+            return false;
+
+        const auto& s = clients[index].queue.stats();
+        out.sockfd = clients[index].sockfd;
+        out.enqueued = s.enqueued;
+        out.sent = s.sent;
+        out.dropped = s.dropped;
+        out.coalesced = s.coalesced;
+        out.depth = s.depth;
+        out.highWater = s.highWater;
+        return true;
+    }
+
+    FanoutStats GetFanoutStats() {
+        LOCK(clientMutex);
+        return fanout;
     }
 
 protected:
+    /// Renders one frame for a single client and queues it on flush().
+    class QueueStream : public Stream {
+    public:
+        QueueStream(HttpSseEndpoint& owner, ClientSlot& slot)
+            : owner(owner), slot(slot), builder(MaxFrameSize) {}
+
+        ~QueueStream() override { flush(); }
+
+        size_t write(const void* data, size_t len) override {
+            if (slot.state != SlotState::Active)
+                return 0;
+            return builder.write(data, len);
+        }
+
+        size_t read(void* buffer, size_t len) override {
+            assert(false && "QueueStream does not support read()");
+            return 0; // not supported
+        }
+
+        void flush() override {
+            if (builder.Truncated()) {
+                ESP_LOGW(TAG, "Dropping oversized frame for fd=%d", slot.sockfd);
+            }
+            SharedFrameRef frame = builder.Finish();
+            if (frame && !owner.enqueue(slot, frame)) {
+                evict = true;
+            }
+        }
+
+        bool evicted() const { return evict; }
+
+    private:
+        HttpSseEndpoint& owner;
+        ClientSlot& slot;
+        SharedFrameBuilder builder;
+        bool evict = false;
+    };
+
     virtual void OnConnect(Stream& /*s*/) {
         // default: do nothing
     }
 
+    /// Drop a client from our side. The slot stays reserved until httpd has
+    /// closed the session, so a late close callback cannot hit a reused slot.
+    /// Caller holds clientMutex.
     void cleanup(ClientSlot& c) {
         ESP_LOGI(TAG, "Cleaning up client fd=%d", c.sockfd);
-        c.active = false;
+        c.replayFrom = 0;
+        c.queue.clear();
+        if (c.server && c.sockfd >= 0 && httpd_sess_trigger_close(c.server, c.sockfd) == ESP_OK) {
+            c.state = SlotState::Closing;
+            return;
+        }
+        release(c);
+    }
+
+    /// Return a slot to the free pool. Caller holds clientMutex.
+    void release(ClientSlot& c) {
+        c.state = SlotState::Free;
         c.server = nullptr;
         c.sockfd = -1;
+        c.replayFrom = 0;
+        c.queue.clear();
     }
 
 private:
+    static constexpr TickType_t WriterPollTicks = pdMS_TO_TICKS(10);
+    static constexpr int RetryAfterSeconds = 5;
+
     ClientSlot clients[MaxClients];
     Mutex clientMutex;
+    Semaphore writerWake;
+    Task writerTask;
+    FrameOverflowPolicy policy;
+    SharedFrameRef keepAliveFrame;
+    FanoutStats fanout;
+    uint32_t nextEventId = 1;
+    ReplayEntry replay[ReplayDepth];
+    size_t replayHead = 0;  // oldest entry
+    size_t replayCount = 0;
     static constexpr const char* TAG = "HttpSSE";
+
+    /// Caller holds clientMutex. Returns false if the client must be evicted.
+    bool enqueue(ClientSlot& c, const SharedFrameRef& frame) {
+        if (c.queue.push(frame, policy) == Queue::PushResult::Full) {
+            ESP_LOGW(TAG, "Client fd=%d queue full, evicting", c.sockfd);
+            return false;
+        }
+        fanout.deliveries++;
+        c.lastQueued = xTaskGetTickCount();
+        return true;
+    }
+
+    ClientSlot* reserveSlot(httpd_handle_t server, int fd, const Filter& filter) {
+        LOCK(clientMutex);
+        for (auto& c : clients) {
+            if (c.state == SlotState::Free) {
+                c.state = SlotState::Connecting;
+                c.server = server;
+                c.sockfd = fd;
+                c.filter = filter;
+                c.replayFrom = 0;
+                c.lastQueued = xTaskGetTickCount();
+                c.queue.clear();
+                return &c;
+            }
+        }
+        return nullptr;
+    }
+
+    /// httpd session free_ctx hook, runs on the server task when the socket closes.
+    static void onSessionClosed(void* ctx) {
+        auto* c = static_cast<ClientSlot*>(ctx);
+        LOCK(c->owner->clientMutex);
+        ESP_LOGI(TAG, "SSE session closed (fd=%d)", c->sockfd);
+        c->owner->release(*c);
+    }
+
+    static bool readFilter(httpd_req_t* req, Filter& filter) {
+        char query[256];
+        size_t len = httpd_req_get_url_query_len(req);
+        if (len == 0)
+            return filter.Parse("");
+        if (len >= sizeof(query))
+            return false;
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK)
+            return false;
+        return filter.Parse(query);
+    }
+
+    static bool readLastEventId(httpd_req_t* req, uint32_t& id) {
+        char value[16];
+        if (httpd_req_get_hdr_value_str(req, "Last-Event-ID", value, sizeof(value)) != ESP_OK)
+            return false;
+        char* end = nullptr;
+        unsigned long parsed = strtoul(value, &end, 10);
+        if (end == value)
+            return false;
+        id = (uint32_t)parsed;
+        return true;
+    }
+
+    void publishChunk(const Event* events, size_t count) {
+        LOCK(clientMutex);
+
+        uint32_t ids[MaxBatchEvents];
+        for (size_t i = 0; i < count; i++) {
+            ids[i] = 0;
+            if (!events[i].body)
+                continue;
+            ids[i] = nextEventId++;
+            fanout.bytesFormatted += events[i].body->Size();
+            remember(ids[i], events[i].tag, events[i].body);
+        }
+
+        // Distinct subsets of the batch accepted by the connected filters
+        uint32_t viewMasks[MaxClients];
+        SharedFrameRef viewFrames[MaxClients];
+        size_t views = 0;
+
+        for (size_t c = 0; c < MaxClients; c++) {
+            ClientSlot& client = clients[c];
+            // Replaying clients pick these events up from the ring, in order
+            if (client.state != SlotState::Active || client.replayFrom != 0)
+                continue;
+
+            uint32_t mask = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (ids[i] && client.filter.Matches(events[i].tag))
+                    mask |= 1u << i;
+            }
+            if (mask == 0)
+                continue;
+
+            size_t v = 0;
+            while (v < views && viewMasks[v] != mask)
+                v++;
+            if (v == views) {
+                const SharedFrameRef* bodies[MaxBatchEvents];
+                size_t n = 0;
+                uint32_t lastId = 0;
+                for (size_t i = 0; i < count; i++) {
+                    if (mask & (1u << i)) {
+                        bodies[n++] = &events[i].body;
+                        lastId = ids[i];
+                    }
+                }
+                viewMasks[views] = mask;
+                viewFrames[views] = assemble(bodies, n, lastId);
+                views++;
+            }
+
+            if (viewFrames[v] && !enqueue(client, viewFrames[v]))
+                cleanup(client);
+        }
+    }
+
+    /// Wrap pre-rendered bodies in one SSE event; several become a JSON array.
+    /// Only bytes are copied here, nothing is serialized again.
+    /// Caller holds clientMutex.
+    SharedFrameRef assemble(const SharedFrameRef* const* bodies, size_t count, uint32_t lastId) {
+        char head[32];
+        int headLen = snprintf(head, sizeof(head), "id: %lu\ndata: ", (unsigned long)lastId);
+
+        size_t size = headLen + 2 + (count > 1 ? count + 1 : 0);
+        for (size_t i = 0; i < count; i++)
+            size += (*bodies[i])->Size();
+
+        SharedFrameBuilder frame(size, count == 1 ? (*bodies[0])->Key() : 0);
+        frame.write(head, headLen);
+        if (count > 1)
+            frame.write("[", 1);
+        for (size_t i = 0; i < count; i++) {
+            if (i > 0)
+                frame.write(",", 1);
+            frame.write((*bodies[i])->Data(), (*bodies[i])->Size());
+        }
+        if (count > 1)
+            frame.write("]", 1);
+        frame.write("\n\n", 2);
+
+        fanout.frames++;
+        return frame.Finish();
+    }
+
+    /// Caller holds clientMutex.
+    void remember(uint32_t id, const Tag& tag, const SharedFrameRef& body) {
+        size_t slot = (replayHead + replayCount) % ReplayDepth;
+        if (replayCount == ReplayDepth) {
+            replayHead = (replayHead + 1) % ReplayDepth;
+        } else {
+            replayCount++;
+        }
+        replay[slot].id = id;
+        replay[slot].tag = tag;
+        replay[slot].body = body;
+    }
+
+    /// First id to replay for a client that last saw `lastEventId`, or 0 if
+    /// it is up to date. Caller holds clientMutex.
+    uint32_t replayStart(uint32_t lastEventId) const {
+        if (replayCount == 0)
+            return 0;
+        uint32_t newest = replay[(replayHead + replayCount - 1) % ReplayDepth].id;
+        if (lastEventId == newest)
+            return 0;
+        if (lastEventId > newest)
+            return replay[replayHead].id; // id from before a reboot: everything is new
+        uint32_t oldest = replay[replayHead].id;
+        if (lastEventId + 1 < oldest)
+            ESP_LOGW(TAG, "Replay gap: client at %lu, oldest kept %lu",
+                     (unsigned long)lastEventId, (unsigned long)oldest);
+        return lastEventId + 1;
+    }
+
+    /// Top up a replaying client's queue from the ring without overflowing it,
+    /// batching missed events the same way as live ones.
+    /// Caller holds clientMutex.
+    void refill(ClientSlot& c) {
+        while (c.replayFrom != 0 && !c.queue.full()) {
+            const SharedFrameRef* bodies[MaxBatchEvents];
+            size_t n = 0;
+            uint32_t lastId = 0;
+            bool more = false;
+
+            for (size_t i = 0; i < replayCount; i++) {
+                const ReplayEntry& e = replay[(replayHead + i) % ReplayDepth];
+                if (e.id < c.replayFrom)
+                    continue;
+                if (n == MaxBatchEvents) {
+                    more = true;
+                    break;
+                }
+                lastId = e.id;
+                if (c.filter.Matches(e.tag))
+                    bodies[n++] = &e.body;
+            }
+
+            if (n > 0) {
+                SharedFrameRef frame = assemble(bodies, n, lastId);
+                if (frame)
+                    enqueue(c, frame);
+            }
+
+            if (!more) {
+                c.replayFrom = 0; // caught up, back to live delivery
+                return;
+            }
+            c.replayFrom = lastId + 1;
+        }
+    }
+
+    void writerLoop() {
+        while (true) {
+            bool backlog = drainAll();
+            // Poll while a socket is backed up, otherwise sleep until new data
+            writerWake.Take(backlog ? WriterPollTicks : portMAX_DELAY);
+        }
+    }
+
+    bool drainAll() {
+        LOCK(clientMutex);
+        bool backlog = false;
+        for (size_t i = 0; i < MaxClients; i++) {
+            if (clients[i].state != SlotState::Active)
+                continue;
+            if (!drain(clients[i])) {
+                cleanup(clients[i]);
+                continue;
+            }
+            backlog |= !clients[i].queue.empty();
+        }
+        return backlog;
+    }
+
+    /// Send as much as the socket accepts without blocking.
+    bool drain(ClientSlot& c) {
+        refill(c);
+        while (!c.queue.empty()) {
+            int sent = httpd_socket_send(c.server, c.sockfd,
+                                         c.queue.pendingData(), c.queue.pendingLen(), MSG_DONTWAIT);
+            fanout.sendCalls++;
+            if (sent == HTTPD_SOCK_ERR_TIMEOUT || sent == 0)
+                return true; // socket buffer full, retry later
+            if (sent < 0)
+                return false;
+            c.queue.consume(sent);
+            refill(c);
+        }
+        return true;
+    }
 };
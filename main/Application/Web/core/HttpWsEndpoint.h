@@ -0,0 +1,369 @@
+#pragma once
+#include "HttpEndpoint.h"
+#include "Mutex.h"
+#include "Semaphore.h"
+#include "Task.h"
+#include "ClientFrameQueue.h"
+#include "SharedFrame.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+
+/// WebSocket endpoint: one socket carries frames in both directions.
+/// The handshake reserves a client slot tied to the httpd session, so the
+/// slot is released whenever httpd closes the socket. Incoming frames are
+/// passed to OnFrame on the server task; Broadcast pushes a frame from any
+/// task to every client whose Filter (parsed from the handshake query) matches.
+/// Clients pick the downlink encoding at connect with `?format=binary|cbor`;
+/// text is the default.
+///
+/// Outgoing frames are encoded once per format into shared buffers and queued
+/// per client, like HttpSseEndpoint; a writer task drains the queues with
+/// non-blocking sends, so a slow client only backs up its own queue. Replies
+/// and control frames (PONG, CLOSE) take the same queue, so nothing else ever
+/// writes to the socket in the middle of a frame.
+template<size_t MaxClients, size_t MaxRxFrame, typename Filter, size_t QueueDepth = 8>
+class HttpWsEndpoint : public HttpEndpoint {
+    constexpr static const char* TAG = "HttpWsEndpoint";
+    using Tag = typename Filter::Tag;
+    using Queue = ClientFrameQueue<QueueDepth>;
+
+    static_assert(MaxRxFrame >= 125, "control frames carry up to 125 bytes");
+
+    enum class SlotState : uint8_t {
+        Free,
+        Active,
+        Draining, // CLOSE answered; closed once the reply is out
+        Closing,  // waiting for httpd to close the session
+    };
+
+public:
+    enum Format : uint8_t {
+        Text,   // sent as text frames
+        Binary, // endpoint-defined packed struct
+        Cbor,
+        FormatCount,
+    };
+
+    struct Payload {
+        const void* data = nullptr;
+        size_t len = 0;
+    };
+
+    struct Client {
+        HttpWsEndpoint* owner = nullptr;
+        httpd_handle_t server = nullptr;
+        int sockfd = -1;
+        SlotState state = SlotState::Free;
+        Format format = Text;
+        Filter filter;
+        Queue queue;
+    };
+
+    struct Stats {
+        uint32_t rxFrames = 0;
+        uint32_t txFrames = 0;  // frames fully written to a socket
+        uint32_t txDropped = 0; // frames dropped from a full queue
+        uint32_t txErrors = 0;
+    };
+
+    explicit HttpWsEndpoint(FrameOverflowPolicy policy = FrameOverflowPolicy::DropOldest)
+        : policy(policy)
+    {
+        for (auto& c : clients)
+            c.owner = this;
+
+        writerTask.Init("WSWriter", 5, 3072);
+        writerTask.SetHandler([this]() { writerLoop(); });
+        writerTask.Run();
+    }
+
+    esp_err_t handle(httpd_req_t* req) override {
+        // httpd has already answered the upgrade when it calls us with GET
+        if (req->method == HTTP_GET)
+            return onHandshake(req);
+        return onFrame(req);
+    }
+
+    /// Queue one frame for every client whose filter accepts `tag`. The caller
+    /// renders each encoding once, indexed by Format; each is framed once and
+    /// shared by the clients that asked for it.
+    void Broadcast(const Tag& tag, const Payload (&payloads)[FormatCount]) {
+        {
+            LOCK(clientMutex);
+            SharedFrameRef frames[FormatCount];
+            for (auto& c : clients) {
+                if (c.state != SlotState::Active || !c.filter.Matches(tag))
+                    continue;
+                SharedFrameRef& frame = frames[c.format];
+                if (!frame) {
+                    const Payload& p = payloads[c.format];
+                    frame = encode(c.format == Text ? HTTPD_WS_TYPE_TEXT : HTTPD_WS_TYPE_BINARY, p.data, p.len);
+                }
+                if (frame && !enqueue(c, frame))
+                    cleanup(c);
+            }
+        }
+        writerWake.Give();
+    }
+
+    /// Queue a reply to a single client, typically from OnFrame.
+    bool Send(Client& c, httpd_ws_type_t type, const void* data, size_t len) {
+        SharedFrameRef frame = encode(type, data, len);
+        bool queued = false;
+        {
+            LOCK(clientMutex);
+            if (frame && c.state == SlotState::Active) {
+                queued = enqueue(c, frame);
+                if (!queued)
+                    cleanup(c);
+            }
+        }
+        writerWake.Give();
+        return queued;
+    }
+
+    Stats GetStats() const {
+        LOCK(clientMutex);
+        return stats;
+    }
+
+protected:
+    /// Called on the server task for every text or binary frame. The payload
+    /// is NUL-terminated so text frames can be parsed in place.
+    virtual void OnFrame(Client& client, const httpd_ws_frame_t& frame) = 0;
+
+private:
+    static constexpr TickType_t WriterPollTicks = pdMS_TO_TICKS(10);
+
+    Client clients[MaxClients];
+    Mutex clientMutex;
+    Semaphore writerWake;
+    Task writerTask;
+    FrameOverflowPolicy policy;
+    Stats stats;
+
+    esp_err_t onHandshake(httpd_req_t* req) {
+        int fd = httpd_req_to_sockfd(req);
+
+        Filter filter;
+        Format format = Text;
+        if (!readQuery(req, filter, format)) {
+            ESP_LOGW(TAG, "Invalid WebSocket query, closing fd=%d", fd);
+            return ESP_FAIL;
+        }
+
+        LOCK(clientMutex);
+        for (auto& c : clients) {
+            if (c.state == SlotState::Free) {
+                c.state = SlotState::Active;
+                c.server = req->handle;
+                c.sockfd = fd;
+                c.format = format;
+                c.filter = filter;
+                c.queue.clear();
+                req->sess_ctx = &c;
+                req->free_ctx = &HttpWsEndpoint::onSessionClosed;
+                ESP_LOGI(TAG, "WebSocket client %d connected (fd=%d)", (int)(&c - clients), fd);
+                return ESP_OK;
+            }
+        }
+
+        // The upgrade is already sent, so failing here just closes the socket
+        ESP_LOGW(TAG, "All %d WebSocket slots in use, closing fd=%d", (int)MaxClients, fd);
+        return ESP_FAIL;
+    }
+
+    esp_err_t onFrame(httpd_req_t* req) {
+        auto* c = static_cast<Client*>(req->sess_ctx);
+
+        httpd_ws_frame_t frame = {};
+        esp_err_t err = httpd_ws_recv_frame(req, &frame, 0); // length only
+        if (err != ESP_OK)
+            return err;
+        if (frame.len > MaxRxFrame) {
+            ESP_LOGW(TAG, "Frame of %u bytes exceeds %u, closing", (unsigned)frame.len, (unsigned)MaxRxFrame);
+            return ESP_FAIL;
+        }
+
+        uint8_t payload[MaxRxFrame + 1];
+        frame.payload = payload;
+        if (frame.len > 0) {
+            err = httpd_ws_recv_frame(req, &frame, frame.len);
+            if (err != ESP_OK)
+                return err;
+        }
+        payload[frame.len] = '\0';
+
+        if (!c)
+            return ESP_FAIL;
+
+        switch (frame.type) {
+        case HTTPD_WS_TYPE_TEXT:
+        case HTTPD_WS_TYPE_BINARY:
+            break;
+        case HTTPD_WS_TYPE_PING:
+            Send(*c, HTTPD_WS_TYPE_PONG, frame.payload, frame.len);
+            return ESP_OK;
+        case HTTPD_WS_TYPE_CLOSE:
+            onClose(*c, frame);
+            return ESP_OK;
+        default:
+            return ESP_OK;
+        }
+
+        {
+            LOCK(clientMutex);
+            stats.rxFrames++;
+        }
+        OnFrame(*c, frame);
+        return ESP_OK;
+    }
+
+    /// Echo the status code and close once the reply has gone out.
+    void onClose(Client& c, const httpd_ws_frame_t& frame) {
+        SharedFrameRef reply = encode(HTTPD_WS_TYPE_CLOSE, frame.payload, frame.len >= 2 ? 2 : 0);
+        {
+            LOCK(clientMutex);
+            if (c.state != SlotState::Active)
+                return;
+            if (reply && enqueue(c, reply))
+                c.state = SlotState::Draining;
+            else
+                cleanup(c);
+        }
+        writerWake.Give();
+    }
+
+    /// Server-to-client frame: FIN, opcode, unmasked length, payload.
+    static SharedFrameRef encode(httpd_ws_type_t type, const void* data, size_t len) {
+        uint8_t header[10];
+        size_t headerLen = 2;
+        header[0] = 0x80 | (uint8_t)type;
+        if (len < 126) {
+            header[1] = (uint8_t)len;
+        } else if (len <= 0xFFFF) {
+            header[1] = 126;
+            header[2] = (uint8_t)(len >> 8);
+            header[3] = (uint8_t)len;
+            headerLen = 4;
+        } else {
+            header[1] = 127;
+            for (int i = 0; i < 8; i++)
+                header[2 + i] = (uint8_t)((uint64_t)len >> (56 - 8 * i));
+            headerLen = 10;
+        }
+
+        SharedFrameBuilder builder(headerLen + len);
+        builder.write(header, headerLen);
+        if (len)
+            builder.write(data, len);
+        return builder.Finish();
+    }
+
+    /// Caller holds clientMutex. Returns false if the client must be closed.
+    bool enqueue(Client& c, const SharedFrameRef& frame) {
+        auto result = c.queue.push(frame, policy);
+        if (result == Queue::PushResult::Full) {
+            ESP_LOGW(TAG, "Client fd=%d queue full, closing", c.sockfd);
+            return false;
+        }
+        if (result == Queue::PushResult::DroppedOldest)
+            stats.txDropped++;
+        return true;
+    }
+
+    /// Drop a client from our side; the slot stays reserved until httpd has
+    /// closed the session. Caller holds clientMutex.
+    void cleanup(Client& c) {
+        c.queue.clear();
+        if (c.server && c.sockfd >= 0 && httpd_sess_trigger_close(c.server, c.sockfd) == ESP_OK) {
+            c.state = SlotState::Closing;
+            return;
+        }
+        release(c);
+    }
+
+    /// Caller holds clientMutex.
+    void release(Client& c) {
+        c.state = SlotState::Free;
+        c.server = nullptr;
+        c.sockfd = -1;
+        c.queue.clear();
+    }
+
+    void writerLoop() {
+        while (true) {
+            bool backlog = drainAll();
+            // Poll while a socket is backed up, otherwise sleep until new data
+            writerWake.Take(backlog ? WriterPollTicks : portMAX_DELAY);
+        }
+    }
+
+    bool drainAll() {
+        LOCK(clientMutex);
+        bool backlog = false;
+        for (auto& c : clients) {
+            if (c.state != SlotState::Active && c.state != SlotState::Draining)
+                continue;
+            if (!drain(c)) {
+                stats.txErrors++;
+                ESP_LOGW(TAG, "WebSocket send failed on fd=%d", c.sockfd);
+                cleanup(c);
+                continue;
+            }
+            if (c.state == SlotState::Draining && c.queue.empty())
+                cleanup(c);
+            backlog |= !c.queue.empty();
+        }
+        return backlog;
+    }
+
+    /// Send as much as the socket accepts without blocking. Caller holds clientMutex.
+    bool drain(Client& c) {
+        while (!c.queue.empty()) {
+            size_t before = c.queue.size();
+            int sent = httpd_socket_send(c.server, c.sockfd, c.queue.pendingData(), c.queue.pendingLen(), MSG_DONTWAIT);
+            if (sent == HTTPD_SOCK_ERR_TIMEOUT || sent == 0)
+                return true; // socket buffer full, retry later
+            if (sent < 0)
+                return false;
+            c.queue.consume(sent);
+            if (c.queue.size() < before)
+                stats.txFrames++;
+        }
+        return true;
+    }
+
+    /// httpd session free_ctx hook, runs on the server task when the socket closes.
+    static void onSessionClosed(void* ctx) {
+        auto* c = static_cast<Client*>(ctx);
+        LOCK(c->owner->clientMutex);
+        ESP_LOGI(TAG, "WebSocket session closed (fd=%d)", c->sockfd);
+        c->owner->release(*c);
+    }
+
+    static bool readQuery(httpd_req_t* req, Filter& filter, Format& format) {
+        char query[256];
+        size_t len = httpd_req_get_url_query_len(req);
+        if (len == 0)
+            return filter.Parse("");
+        if (len >= sizeof(query))
+            return false;
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK)
+            return false;
+
+        char value[8];
+        if (httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK) {
+            if (strcmp(value, "binary") == 0)
+                format = Binary;
+            else if (strcmp(value, "cbor") == 0)
+                format = Cbor;
+            else if (strcmp(value, "text") != 0)
+                return false;
+        }
+        return filter.Parse(query);
+    }
+};
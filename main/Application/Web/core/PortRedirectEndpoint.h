@@ -0,0 +1,46 @@
+#pragma once
+#include "HttpEndpoint.h"
+#include <stdio.h>
+#include <string.h>
+
+/// Sends the request on to the same host and path on another port with
+/// 307, which keeps the method and body. Lets pages served from one server
+/// keep using relative URLs for routes that live on another.
+class PortRedirectEndpoint : public HttpEndpoint
+{
+public:
+    explicit PortRedirectEndpoint(uint16_t port)
+        : port(port)
+    {
+    }
+
+    esp_err_t handle(httpd_req_t *req) override
+    {
+        char host[64];
+        if (httpd_req_get_hdr_value_str(req, "Host", host, sizeof(host)) != ESP_OK)
+        {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Host header required");
+            return ESP_FAIL;
+        }
+
+        // Drop the port the client used; keep IPv6 brackets intact
+        char *colon = strrchr(host, ':');
+        if (colon && !strchr(colon, ']'))
+            *colon = '\0';
+
+        char location[160];
+        int len = snprintf(location, sizeof(location), "http://%s:%u%s", host, (unsigned)port, req->uri);
+        if (len < 0 || (size_t)len >= sizeof(location))
+        {
+            httpd_resp_send_err(req, HTTPD_414_URI_TOO_LONG, "URI too long");
+            return ESP_FAIL;
+        }
+
+        httpd_resp_set_status(req, "307 Temporary Redirect");
+        httpd_resp_set_hdr(req, "Location", location);
+        return httpd_resp_send(req, nullptr, 0);
+    }
+
+private:
+    uint16_t port;
+};
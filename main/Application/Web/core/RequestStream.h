@@ -0,0 +1,53 @@
+#pragma once
+#include "Stream.h"
+#include "esp_http_server.h"
+
+/// Reads the request body straight from the socket, chunk by chunk,
+/// stopping at Content-Length.
+class RequestStream : public Stream
+{
+    static constexpr int MaxTimeouts = 3;
+
+    httpd_req_t *req;
+    size_t remaining;
+    bool failed = false;
+
+public:
+    explicit RequestStream(httpd_req_t *r) : req(r), remaining(r->content_len) {}
+
+    size_t write(const void *data, size_t len) override
+    {
+        assert(false && "RequestStream does not support write()");
+        return 0; // not supported
+    }
+
+    size_t read(void *buffer, size_t len) override
+    {
+        if (remaining == 0 || failed)
+            return 0;
+        if (len > remaining)
+            len = remaining;
+
+        for (int timeouts = 0;;)
+        {
+            int ret = httpd_req_recv(req, (char *)buffer, len);
+            if (ret > 0)
+            {
+                remaining -= ret;
+                return ret;
+            }
+            if (ret != HTTPD_SOCK_ERR_TIMEOUT || ++timeouts == MaxTimeouts)
+                break;
+        }
+        failed = true;
+        return 0;
+    }
+
+    void flush() override
+    {
+        // do nothing, just keep interface happy
+    }
+
+    /// True if the connection failed before the whole body arrived.
+    bool Failed() const { return failed; }
+};
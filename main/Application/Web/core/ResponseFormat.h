@@ -0,0 +1,69 @@
+#pragma once
+#include "esp_http_server.h"
+#include "json.h"
+#include "cbor.h"
+#include <string.h>
+
+/// Body encoding for API responses. JSON unless the client asks for CBOR
+/// with `Accept: application/cbor` or `?format=cbor`.
+/// Endpoints write through a generic lambda, so one body definition serves both:
+///
+///   ResponseFormat::WriteObject(format, stream, [&](auto& obj) { obj.field("id", id); });
+class ResponseFormat
+{
+public:
+    enum Type : uint8_t
+    {
+        Json,
+        Cbor,
+    };
+
+    static Type Negotiate(httpd_req_t *req)
+    {
+        // A truncated query or header still holds the part we look for
+        char query[64];
+        char value[8];
+        if (usable(httpd_req_get_url_query_str(req, query, sizeof(query))) &&
+            httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK)
+        {
+            return strcmp(value, "cbor") == 0 ? Cbor : Json;
+        }
+
+        char accept[64];
+        if (usable(httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept))) &&
+            strstr(accept, "application/cbor"))
+        {
+            return Cbor;
+        }
+        return Json;
+    }
+
+    static const char *ContentType(Type type)
+    {
+        return type == Cbor ? "application/cbor" : "application/json";
+    }
+
+    template <typename FUNC>
+    static void WriteObject(Type type, Stream &stream, FUNC callback)
+    {
+        if (type == Cbor)
+            CborObjectWriter::create(stream, callback);
+        else
+            JsonObjectWriter::create(stream, callback);
+    }
+
+    template <typename FUNC>
+    static void WriteArray(Type type, Stream &stream, FUNC callback)
+    {
+        if (type == Cbor)
+            CborArrayWriter::create(stream, callback);
+        else
+            JsonArrayWriter::create(stream, callback);
+    }
+
+private:
+    static bool usable(esp_err_t err)
+    {
+        return err == ESP_OK || err == ESP_ERR_HTTPD_RESULT_TRUNC;
+    }
+};
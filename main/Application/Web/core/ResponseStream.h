@@ -1,15 +1,33 @@
 #pragma once
 #include "Stream.h"
 #include "esp_http_server.h"
+#include "esp_log.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
 
-class ResponseStream : public Stream
+/// Response body writer that coalesces small writes.
+/// Writers emit punctuation and quotes one byte at a time, so everything is
+/// collected in a fixed buffer first. A body that fits is sent by close() in
+/// one httpd_resp_send() with a real Content-Length; a larger one switches to
+/// chunked encoding and goes out one full buffer per chunk.
+template <size_t BufferSize>
+class BasicResponseStream : public Stream
 {
+    constexpr static const char *TAG = "ResponseStream";
+
     httpd_req_t *req;
+    char buffer[BufferSize];
+    size_t used = 0;
+    size_t bytes = 0;
+    uint16_t sends = 0;
+    bool chunked = false;
+    bool failed = false;
     bool closed = false;
 
 public:
-    explicit ResponseStream(httpd_req_t *r) : req(r) {}
-    ~ResponseStream()
+    explicit BasicResponseStream(httpd_req_t *r) : req(r) {}
+    ~BasicResponseStream()
     {
         if (!closed)
         {
@@ -19,12 +37,24 @@ public:
 
     size_t write(const void *data, size_t len) override
     {
-        int ret = httpd_resp_send_chunk(req, (const char *)data, len);
-        if (ret == ESP_OK)
+        if (failed || closed)
+            return 0;
+
+        const char *src = (const char *)data;
+        size_t left = len;
+        while (left > 0)
         {
-            return len;
+            if (used == BufferSize && !sendChunk(buffer, used))
+                return 0;
+
+            size_t n = BufferSize - used < left ? BufferSize - used : left;
+            memcpy(buffer + used, src, n);
+            used += n;
+            src += n;
+            left -= n;
         }
-        return 0;
+        bytes += len;
+        return len;
     }
 
     size_t read(void *buffer, size_t len) override
@@ -33,14 +63,59 @@ public:
         return 0; // not supported
     }
 
+    /// Deliberately does not send: escaping streams flush after every string,
+    /// which would undo the coalescing. Data goes out when the buffer fills
+    /// and on close().
     void flush() override
     {
-        // do nothing, just keep interface happy
     }
 
     void close()
     {
-        httpd_resp_send_chunk(req, nullptr, 0); // end of response
+        if (closed)
+            return;
         closed = true;
+        if (failed)
+            return;
+
+        if (!chunked)
+        {
+            sends++;
+            failed = httpd_resp_send(req, buffer, used) != ESP_OK;
+        }
+        else
+        {
+            if (used > 0)
+                sendChunk(buffer, used);
+            if (!failed)
+            {
+                sends++;
+                failed = httpd_resp_send_chunk(req, nullptr, 0) != ESP_OK; // end of response
+            }
+        }
+        ESP_LOGD(TAG, "%s: %u bytes in %u sends%s", req->uri, (unsigned)bytes, (unsigned)sends,
+                 chunked ? " (chunked)" : "");
+    }
+
+    /// Socket sends issued for this response so far, including the final one.
+    uint16_t Sends() const { return sends; }
+    size_t Bytes() const { return bytes; }
+    bool Failed() const { return failed; }
+
+private:
+    bool sendChunk(const char *data, size_t len)
+    {
+        chunked = true;
+        sends++;
+        if (httpd_resp_send_chunk(req, data, len) != ESP_OK)
+        {
+            failed = true;
+            return false;
+        }
+        used = 0;
+        return true;
     }
 };
+
+/// Sized for the API replies; lives on the httpd task stack.
+using ResponseStream = BasicResponseStream<512>;
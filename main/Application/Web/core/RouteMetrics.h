@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "WideCounter.h"
+
+/// Access counters for one route, updated from the dispatcher with relaxed
+/// atomics only (no locks, no allocation). Everything is 32-bit, as the
+/// ESP32 has no lock-free 64-bit atomics. Counters wrap, which Prometheus
+/// treats as a counter reset. The latency sum would wrap after 71 minutes
+/// of handler time in 32-bit microseconds, out of step with the request
+/// count, so it is a WideCounter: two 32-bit words, the low one and its
+/// carries.
+///
+/// Latency is handler time. Streaming routes (SSE, WebSocket) record their
+/// handshake when it completes; the stream's lifetime is not a request.
+struct RouteMetrics
+{
+    /// Upper bounds of the latency histogram in microseconds; one more bucket
+    /// collects everything slower.
+    constexpr static uint32_t BucketBoundsUs[] = {
+        500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000};
+    constexpr static size_t BucketCount = sizeof(BucketBoundsUs) / sizeof(BucketBoundsUs[0]) + 1;
+
+    /// Status classes 1xx..5xx, plus index 0 for requests that sent nothing.
+    constexpr static size_t StatusClassCount = 6;
+
+    std::atomic<uint32_t> requests{0};
+    std::atomic<uint32_t> inFlight{0};
+    std::atomic<uint32_t> bytesSent{0};
+    WideCounter latencyUsSum;
+    std::atomic<uint32_t> status[StatusClassCount] = {};
+    std::atomic<uint32_t> buckets[BucketCount] = {};
+
+    void Begin()
+    {
+        inFlight.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void End(uint32_t latencyUs, uint16_t statusCode, uint32_t bytes)
+    {
+        size_t b = 0;
+        while (b < BucketCount - 1 && latencyUs > BucketBoundsUs[b])
+            b++;
+        size_t cls = statusCode / 100;
+        if (cls >= StatusClassCount)
+            cls = 0;
+
+        buckets[b].fetch_add(1, std::memory_order_relaxed);
+        status[cls].fetch_add(1, std::memory_order_relaxed);
+        latencyUsSum.Add(latencyUs);
+        bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+        requests.fetch_add(1, std::memory_order_relaxed);
+        inFlight.fetch_sub(1, std::memory_order_relaxed);
+    }
+};
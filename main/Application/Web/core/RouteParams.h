@@ -0,0 +1,38 @@
+#pragma once
+#include <stddef.h>
+#include <string.h>
+
+/// Path parameters captured by a route match. Values point into the request
+/// URI and are not NUL-terminated; use Get() to copy one out.
+struct RouteParams
+{
+    static constexpr size_t MaxParams = 4;
+
+    struct Param
+    {
+        const char *name;
+        size_t nameLen;
+        const char *value;
+        size_t valueLen;
+    };
+
+    Param params[MaxParams];
+    size_t count = 0;
+
+    bool Get(const char *name, char *out, size_t outSize) const
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const Param &p = params[i];
+            if (p.nameLen == strlen(name) && strncmp(p.name, name, p.nameLen) == 0)
+            {
+                if (p.valueLen >= outSize)
+                    return false;
+                memcpy(out, p.value, p.valueLen);
+                out[p.valueLen] = '\0';
+                return true;
+            }
+        }
+        return false;
+    }
+};
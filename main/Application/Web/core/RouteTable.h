@@ -0,0 +1,201 @@
+#pragma once
+#include "esp_http_server.h"
+#include "RouteParams.h"
+#include "StaticVector.h"
+#include <stdint.h>
+#include <string.h>
+
+/// Routes as a trie over path segments, held in a fixed node pool.
+/// Patterns are literals such as "/api/score", "/api/tx/{id}" or "/*":
+/// `{name}` matches one segment and captures it, a trailing `*` matches the
+/// rest of the path. At each segment a literal beats a parameter, which beats
+/// a wildcard, so registration order does not matter. Lookup walks the path
+/// once, backtracking only into a parameter branch when the literal one fails.
+/// `Target` is whatever the owner wants back for a match; it is not owned.
+template <typename Target, size_t MaxNodes = 48>
+class RouteTable
+{
+public:
+    enum class Result
+    {
+        Found,
+        NotFound,
+        MethodNotAllowed,
+    };
+
+    bool Add(const char *pattern, httpd_method_t method, Target &handler)
+    {
+        int m = methodIndex(method);
+        if (m < 0)
+            return false;
+        if (nodes.empty() && !nodes.try_push_back(Node{}))
+            return false;
+
+        int16_t node = 0;
+        const char *p = pattern;
+        while (true)
+        {
+            while (*p == '/')
+                p++;
+            if (*p == '\0')
+                break;
+            if (p[0] == '*' && p[1] == '\0')
+            {
+                nodes[node].wildcard[m] = &handler;
+                return true;
+            }
+
+            size_t len = strcspn(p, "/");
+            node = child(node, p, len);
+            if (node < 0)
+                return false; // pool exhausted
+            p += len;
+        }
+        nodes[node].handlers[m] = &handler;
+        return true;
+    }
+
+    /// Match `uri` (query string ignored) against the table.
+    Result Find(const char *uri, httpd_method_t method, Target *&handler, RouteParams &params) const
+    {
+        handler = nullptr;
+        params.count = 0;
+        int m = methodIndex(method);
+        if (nodes.empty())
+            return Result::NotFound;
+
+        size_t len = strcspn(uri, "?#");
+        bool pathMatched = false;
+        if (match(0, uri, uri + len, m, handler, params, pathMatched))
+            return Result::Found;
+        return pathMatched ? Result::MethodNotAllowed : Result::NotFound;
+    }
+
+    size_t NodeCount() const { return nodes.size(); }
+
+private:
+    static constexpr size_t MethodCount = 7;
+
+    struct Node
+    {
+        const char *segment = nullptr; // literal, or the name inside {}
+        uint8_t segmentLen = 0;
+        bool param = false;
+        int16_t firstChild = -1;
+        int16_t nextSibling = -1;
+        Target *handlers[MethodCount] = {};
+        Target *wildcard[MethodCount] = {};
+    };
+
+    StaticVector<Node, MaxNodes> nodes;
+
+    static int methodIndex(httpd_method_t method)
+    {
+        switch (method)
+        {
+        case HTTP_GET: return 0;
+        case HTTP_HEAD: return 1;
+        case HTTP_POST: return 2;
+        case HTTP_PUT: return 3;
+        case HTTP_DELETE: return 4;
+        case HTTP_OPTIONS: return 5;
+        case HTTP_PATCH: return 6;
+        default: return -1;
+        }
+    }
+
+    /// Find or create the child of `parent` for one pattern segment.
+    int16_t child(int16_t parent, const char *seg, size_t len)
+    {
+        bool param = len >= 2 && seg[0] == '{' && seg[len - 1] == '}';
+        const char *name = param ? seg + 1 : seg;
+        size_t nameLen = param ? len - 2 : len;
+
+        for (int16_t c = nodes[parent].firstChild; c >= 0; c = nodes[c].nextSibling)
+        {
+            const Node &n = nodes[c];
+            if (n.param == param && (param || (n.segmentLen == nameLen && strncmp(n.segment, name, nameLen) == 0)))
+                return c; // parameter names are per route; the first one wins
+        }
+
+        Node n;
+        n.segment = name;
+        n.segmentLen = (uint8_t)nameLen;
+        n.param = param;
+        n.nextSibling = nodes[parent].firstChild;
+        if (!nodes.try_push_back(n))
+            return -1;
+        int16_t index = (int16_t)(nodes.size() - 1);
+        nodes[parent].firstChild = index;
+        return index;
+    }
+
+    bool match(int16_t node, const char *p, const char *end, int m, Target *&handler,
+               RouteParams &params, bool &pathMatched) const
+    {
+        const Node &n = nodes[node];
+        while (p < end && *p == '/')
+            p++;
+
+        if (p == end)
+        {
+            if (hasAny(n.handlers))
+                pathMatched = true;
+            if (m >= 0 && n.handlers[m])
+            {
+                handler = n.handlers[m];
+                return true;
+            }
+        }
+        else
+        {
+            const char *segEnd = p;
+            while (segEnd < end && *segEnd != '/')
+                segEnd++;
+            size_t len = segEnd - p;
+
+            // Literal children first, then a parameter child
+            for (int pass = 0; pass < 2; pass++)
+            {
+                for (int16_t c = n.firstChild; c >= 0; c = nodes[c].nextSibling)
+                {
+                    const Node &cn = nodes[c];
+                    if (cn.param != (pass == 1))
+                        continue;
+                    if (!cn.param && (cn.segmentLen != len || strncmp(cn.segment, p, len) != 0))
+                        continue;
+
+                    size_t saved = params.count;
+                    if (cn.param)
+                    {
+                        if (params.count == RouteParams::MaxParams)
+                            continue;
+                        params.params[params.count++] = {cn.segment, cn.segmentLen, p, len};
+                    }
+                    if (match(c, segEnd, end, m, handler, params, pathMatched))
+                        return true;
+                    params.count = saved;
+                }
+            }
+        }
+
+        if (hasAny(n.wildcard))
+            pathMatched = true;
+        if (m >= 0 && n.wildcard[m])
+        {
+            handler = n.wildcard[m];
+            return true;
+        }
+        return false;
+    }
+
+    static bool hasAny(Target *const (&handlers)[MethodCount])
+    {
+        for (auto *h : handlers)
+        {
+            if (h)
+                return true;
+        }
+        return false;
+    }
+};
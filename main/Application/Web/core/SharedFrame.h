@@ -0,0 +1,168 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include "Stream.h"
+
+/// Rendered outbound frame (an SSE event or a WebSocket frame), allocated
+/// once and shared by every client queue.
+/// The payload lives directly behind the header in the same allocation.
+class SharedFrame
+{
+    friend class SharedFrameBuilder;
+
+public:
+    static SharedFrame *Create(size_t capacity, uint16_t key = 0)
+    {
+        void *mem = malloc(sizeof(SharedFrame) + capacity);
+        if (!mem)
+            return nullptr;
+        return new (mem) SharedFrame(capacity, key);
+    }
+
+    SharedFrame(const SharedFrame &) = delete;
+    SharedFrame &operator=(const SharedFrame &) = delete;
+
+    void Retain() { refs.fetch_add(1, std::memory_order_relaxed); }
+
+    void Release()
+    {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            this->~SharedFrame();
+            free(this);
+        }
+    }
+
+    const char *Data() const { return reinterpret_cast<const char *>(this + 1); }
+    size_t Size() const { return size; }
+    size_t Capacity() const { return capacity; }
+
+    /// Frames with the same non-zero key may replace each other in a full queue.
+    uint16_t Key() const { return key; }
+
+private:
+    SharedFrame(size_t capacity, uint16_t key)
+        : capacity(static_cast<uint32_t>(capacity)), key(key) {}
+    ~SharedFrame() = default;
+
+    char *Data() { return reinterpret_cast<char *>(this + 1); }
+
+    std::atomic<uint32_t> refs{1};
+    uint32_t size = 0;
+    uint32_t capacity;
+    uint16_t key;
+};
+
+/// Owning handle to an SharedFrame; copies share the frame.
+class SharedFrameRef
+{
+    SharedFrame *frame = nullptr;
+
+public:
+    SharedFrameRef() = default;
+
+    /// Adopts the reference returned by SharedFrame::Create().
+    explicit SharedFrameRef(SharedFrame *adopt) : frame(adopt) {}
+
+    SharedFrameRef(const SharedFrameRef &other) : frame(other.frame)
+    {
+        if (frame)
+            frame->Retain();
+    }
+
+    SharedFrameRef(SharedFrameRef &&other) noexcept : frame(other.frame) { other.frame = nullptr; }
+
+    SharedFrameRef &operator=(const SharedFrameRef &other)
+    {
+        SharedFrameRef tmp(other);
+        std::swap(frame, tmp.frame);
+        return *this;
+    }
+
+    SharedFrameRef &operator=(SharedFrameRef &&other) noexcept
+    {
+        std::swap(frame, other.frame);
+        return *this;
+    }
+
+    ~SharedFrameRef() { reset(); }
+
+    void reset()
+    {
+        if (frame)
+            frame->Release();
+        frame = nullptr;
+    }
+
+    explicit operator bool() const { return frame != nullptr; }
+    const SharedFrame *operator->() const { return frame; }
+    const SharedFrame &operator*() const { return *frame; }
+};
+
+/// Stream that renders straight into a new SharedFrame.
+/// The frame is allocated on the first write; overflowing it discards the frame.
+class SharedFrameBuilder : public Stream
+{
+    SharedFrame *frame = nullptr;
+    size_t capacity;
+    uint16_t key;
+    bool truncated = false;
+
+public:
+    explicit SharedFrameBuilder(size_t capacity, uint16_t key = 0)
+        : capacity(capacity), key(key) {}
+
+    ~SharedFrameBuilder() override
+    {
+        if (frame)
+            frame->Release();
+    }
+
+    SharedFrameBuilder(const SharedFrameBuilder &) = delete;
+    SharedFrameBuilder &operator=(const SharedFrameBuilder &) = delete;
+
+    size_t write(const void *data, size_t len) override
+    {
+        if (truncated)
+            return 0;
+        if (!frame)
+            frame = SharedFrame::Create(capacity, key);
+        if (!frame || frame->size + len > frame->capacity)
+        {
+            truncated = true;
+            return 0;
+        }
+        memcpy(frame->Data() + frame->size, data, len);
+        frame->size += len;
+        return len;
+    }
+
+    size_t read(void *buffer, size_t len) override
+    {
+        assert(false && "SharedFrameBuilder does not support read()");
+        return 0; // not supported
+    }
+
+    void flush() override {}
+
+    size_t Size() const { return frame ? frame->size : 0; }
+    bool Truncated() const { return truncated; }
+
+    /// Hand out the rendered frame and start over. Empty if nothing was
+    /// written, allocation failed or the frame overflowed.
+    SharedFrameRef Finish()
+    {
+        SharedFrame *done = truncated ? nullptr : frame;
+        if (truncated && frame)
+            frame->Release();
+        frame = nullptr;
+        truncated = false;
+        return SharedFrameRef(done);
+    }
+};
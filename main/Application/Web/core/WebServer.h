@@ -1,12 +1,107 @@
 #pragma once
 #include "esp_err.h"
 #include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_timer.h"
 #include "HttpEndpoint.h"
+#include "Queue.h"
+#include "RouteMetrics.h"
+#include "RouteTable.h"
+#include "StaticVector.h"
+#include "WorkerPool.h"
+#include <assert.h>
+#include <atomic>
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
 
+/// HTTP server with its own route table.
+/// All HTTP routes live in a RouteTable served by one dispatch handler per
+/// method, so esp_http_server's handler list stays tiny and route order does
+/// not matter. WebSocket routes still need their own httpd entries (the
+/// upgrade is decided per handler) and are registered ahead of the dispatchers.
+/// Register everything, then call start().
+///
+/// Every dispatched request is timed and its status line and body bytes are
+/// counted per route (see RouteMetrics). Status and bytes come from a send
+/// override installed on each session, so endpoints need no changes. A
+/// request ends when its handler returns: SSE endpoints return once the
+/// stream is set up and WebSocket handshakes are timed on their own, so
+/// long-lived streams record their handshake, not their lifetime.
+///
+/// Routes registered with an AsyncClass run on a small worker pool instead of
+/// the httpd task (httpd_req_async_handler_begin), so a slow download does
+/// not hold up the API. Each class caps how many of its requests run at once;
+/// the rest wait in the class's queue, still holding their sockets.
+///
+/// Several instances can run side by side, each with its own port, socket
+/// budget and task settings (see Config), so one kind of traffic cannot
+/// starve another of sockets.
 class WebServer
 {
+    constexpr static const char *TAG = "WebServer";
+    constexpr static size_t MaxRoutes = 24;
+    constexpr static size_t MaxOpenSockets = 16; // per instance, upper bound for Config
+    constexpr static size_t MaxWebSockets = 4;
+    constexpr static size_t AsyncWorkers = 6;
+    constexpr static const char *PreflightMaxAge = "600"; // seconds
+    constexpr static httpd_method_t DispatchMethods[] = {
+        HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_DELETE, HTTP_OPTIONS, HTTP_PATCH};
+
 public:
-    WebServer() = default;
+    /// Concurrency budget shared by the async routes registered with it.
+    class AsyncClass
+    {
+    public:
+        AsyncClass(const char *name, uint8_t limit)
+            : name(name), limit(limit), pending(MaxOpenSockets)
+        {
+        }
+
+        const char *GetName() const { return name; }
+        uint8_t GetRunning() const { return running.load(std::memory_order_relaxed); }
+
+    private:
+        friend class WebServer;
+
+        const char *name;
+        uint8_t limit;
+        std::atomic<uint8_t> running{0};
+        Queue<uint8_t> pending; // request slot indexes
+
+        bool tryAcquire()
+        {
+            uint8_t n = running.load(std::memory_order_relaxed);
+            while (n < limit)
+            {
+                if (running.compare_exchange_weak(n, n + 1, std::memory_order_acquire))
+                    return true;
+            }
+            return false;
+        }
+
+        void release()
+        {
+            running.fetch_sub(1, std::memory_order_release);
+        }
+    };
+
+    struct Config
+    {
+        const char *name;
+        uint16_t port;
+        uint16_t ctrlPort;         // UDP control port, unique per instance
+        uint16_t maxOpenSockets;   // <= MaxOpenSockets
+        UBaseType_t priority;      // httpd task and its workers
+        BaseType_t core;           // tskNO_AFFINITY or a core id
+        bool lruPurge;             // close the idlest socket when all are busy
+    };
+
+    explicit WebServer(const Config &config)
+        : settings(config)
+    {
+        assert(settings.maxOpenSockets <= MaxOpenSockets);
+    }
     ~WebServer() { stop(); }
 
     WebServer(const WebServer &) = delete;
@@ -19,11 +114,56 @@ public:
         if (server)
             return;
         httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-        config.max_open_sockets = 8;  // allow 8 concurrent sockets
-        config.max_uri_handlers = 16; // more endpoints
+        config.server_port = settings.port;
+        config.ctrl_port = settings.ctrlPort;
+        config.max_open_sockets = settings.maxOpenSockets;
+        config.task_priority = settings.priority;
+        config.core_id = settings.core;
+        config.lru_purge_enable = settings.lruPurge;
+        config.max_uri_handlers = sizeof(DispatchMethods) / sizeof(DispatchMethods[0]) + MaxWebSockets;
 
         config.uri_match_fn = httpd_uri_match_wildcard;
+        config.open_fn = &WebServer::onOpen;
+        config.global_user_ctx = this;
+        config.global_user_ctx_free_fn = [](void *) {}; // owned by the caller, not httpd
+
+        // Probe idle peers so sockets of clients that vanished without a FIN
+        // (Wi-Fi roam, sleeping phone) get closed, freeing their SSE slots.
+        config.keep_alive_enable = true;
+        config.keep_alive_idle = 5;
+        config.keep_alive_interval = 2;
+        config.keep_alive_count = 3;
         ESP_ERROR_CHECK(httpd_start(&server, &config));
+        size_t workerCount = asyncWorkersNeeded();
+        if (workerCount)
+            workers.Start(settings.name, config.task_priority, config.stack_size, config.core_id, workerCount);
+
+        // httpd matches in registration order: WebSockets before the catch-alls
+        for (size_t i = 0; i < webSockets.size(); i++)
+        {
+            httpd_uri_t ws = {
+                .uri = webSockets[i].uri,
+                .method = HTTP_GET,
+                .handler = &WebServer::wsTrampoline,
+                .user_ctx = &webSockets[i],
+                .is_websocket = true,
+                .handle_ws_control_frames = true};
+            ESP_ERROR_CHECK(httpd_register_uri_handler(server, &ws));
+        }
+
+        for (httpd_method_t method : DispatchMethods)
+        {
+            httpd_uri_t route = {
+                .uri = "/*",
+                .method = method,
+                .handler = &WebServer::dispatch,
+                .user_ctx = this};
+            ESP_ERROR_CHECK(httpd_register_uri_handler(server, &route));
+        }
+
+        ESP_LOGI(TAG, "%s: port %u, %u sockets, %u route nodes, %u WebSockets, %u workers",
+                 settings.name, (unsigned)settings.port, (unsigned)settings.maxOpenSockets,
+                 (unsigned)routes.NodeCount(), (unsigned)webSockets.size(), (unsigned)workerCount);
     }
 
     void stop()
@@ -34,29 +174,121 @@ public:
         server = nullptr;
     }
 
+    /// Answer CORS preflight requests for every path. Browsers may cache the
+    /// answer for PreflightMaxAge, so a cross-origin JSON POST to the same
+    /// URL costs the extra round trip once every few minutes, not per call.
     void EnableCors()
     {
-        // Handle OPTIONS for CORS preflight
-        httpd_uri_t api_options = {
-            .uri = "/*",
-            .method = HTTP_OPTIONS,
-            .handler = api_options_handler,
-            .user_ctx = NULL};
-        httpd_register_uri_handler(server, &api_options);
+        registerHandler("/*", HTTP_OPTIONS, corsPreflight);
     }
 
-    void registerHandler(const char *uri, httpd_method_t method, HttpEndpoint &handler)
+    /// `uri` may contain `{name}` segments and a trailing `*`; see RouteTable.
+    /// With `async` set the handler runs on a worker within that class's limit,
+    /// so it may run concurrently with other handlers.
+    void registerHandler(const char *uri, httpd_method_t method, HttpEndpoint &handler,
+                         AsyncClass *async = nullptr)
     {
-        httpd_uri_t config = {
-            .uri = uri,
-            .method = method,
-            .handler = &WebServer::trampoline,
-            .user_ctx = &handler};
-        ESP_ERROR_CHECK(httpd_register_uri_handler(server, &config));
+        bool added = routeCount < MaxRoutes;
+        if (added)
+        {
+            Route &route = routeList[routeCount];
+            route.pattern = uri;
+            route.method = method;
+            route.handler = &handler;
+            route.async = async;
+            added = routes.Add(uri, method, route);
+            if (added)
+                routeCount++;
+        }
+        if (!added)
+            ESP_LOGE(TAG, "Route table full, cannot add %s", uri);
+        assert(added);
+    }
+
+    /// WebSocket routes bypass the CORS trampoline: httpd answers the upgrade
+    /// itself and later calls the handler once per received frame, control
+    /// frames included, so every frame the server sends goes through the
+    /// endpoint's own send queue (see HttpWsEndpoint).
+    void registerWebSocket(const char *uri, HttpEndpoint &handler)
+    {
+        assert(!server && "register WebSockets before start()");
+        bool added = !webSockets.full() &&
+                     webSockets.try_push_back(WebSocketRoute{uri, &handler, &webSocketMetrics[webSockets.size()]});
+        assert(added && "too many WebSocket routes");
+    }
+
+    const char *GetName() const { return settings.name; }
+    uint16_t GetPort() const { return settings.port; }
+    uint16_t GetMaxOpenSockets() const { return settings.maxOpenSockets; }
+
+    /// Calls fn(route, method, metrics) for every registered route and
+    /// WebSocket, then once for requests that matched none ("unmatched",
+    /// method "*").
+    template <typename FUNC>
+    void ForEachRoute(FUNC fn) const
+    {
+        for (size_t i = 0; i < routeCount; i++)
+            fn(routeList[i].pattern, http_method_str(routeList[i].method), routeList[i].metrics);
+        for (size_t i = 0; i < webSockets.size(); i++)
+            fn(webSockets[i].uri, "GET", webSocketMetrics[i]);
+        fn("unmatched", "*", unmatched);
     }
 
 private:
+    struct Route
+    {
+        const char *pattern = nullptr;
+        httpd_method_t method = HTTP_GET;
+        HttpEndpoint *handler = nullptr;
+        AsyncClass *async = nullptr;
+        RouteMetrics metrics;
+    };
+
+    /// One dispatched request on `fd`, from dispatch until its handler
+    /// returns: what the send override saw of it and, for async routes, the
+    /// job handed to the workers.
+    struct RequestSlot
+    {
+        std::atomic<int> fd{-1};
+        uint16_t status = 0;
+        uint32_t bytes = 0;
+
+        WebServer *server = nullptr;
+        httpd_req_t *req = nullptr;
+        Route *route = nullptr;
+        RouteParams params;
+        int64_t start = 0;
+    };
+
+    struct WebSocketRoute
+    {
+        const char *uri;
+        HttpEndpoint *handler;
+        RouteMetrics *metrics; // handshakes only
+    };
+
+    class CorsPreflight : public HttpEndpoint
+    {
+    public:
+        esp_err_t handle(httpd_req_t *req) override
+        {
+            httpd_resp_set_status(req, "204 No Content");
+            httpd_resp_set_hdr(req, "Access-Control-Max-Age", PreflightMaxAge);
+            return httpd_resp_send(req, NULL, 0);
+        }
+    };
+
+    Config settings;
     httpd_handle_t server = nullptr;
+    Route routeList[MaxRoutes];
+    size_t routeCount = 0;
+    RouteTable<Route> routes;
+    RouteMetrics unmatched;
+    RequestSlot slots[MaxOpenSockets];
+    WorkerPool<AsyncWorkers> workers{MaxOpenSockets};
+    StaticVector<WebSocketRoute, MaxWebSockets> webSockets;
+    RouteMetrics webSocketMetrics[MaxWebSockets];
+    CorsPreflight corsPreflight;
 
     static void set_cors_headers(httpd_req_t *req)
     {
@@ -65,17 +297,205 @@ private:
         httpd_resp_set_hdr(req, "Access-Control-Allow-Headers", "Content-Type");
     }
 
-    static esp_err_t trampoline(httpd_req_t *req)
+    static esp_err_t dispatch(httpd_req_t *req)
+    {
+        int64_t start = esp_timer_get_time();
+        auto *self = static_cast<WebServer *>(req->user_ctx);
+        RequestSlot *slot = self->claimSlot(httpd_req_to_sockfd(req));
+
+        Route *route = nullptr;
+        RouteParams params;
+        auto result = self->routes.Find(req->uri, (httpd_method_t)req->method, route, params);
+        RouteMetrics &metrics = route ? route->metrics : self->unmatched;
+        metrics.Begin();
+
+        if (result == RouteTable<Route>::Result::Found && route->async && slot)
+            return self->defer(req, *slot, route, params, start);
+
+        set_cors_headers(req); // Always inject CORS headers
+        esp_err_t ret = ESP_OK;
+        switch (result)
+        {
+        case RouteTable<Route>::Result::Found:
+            ret = route->handler->handle(req, params);
+            break;
+        case RouteTable<Route>::Result::MethodNotAllowed:
+            httpd_resp_send_err(req, HTTPD_405_METHOD_NOT_ALLOWED, "Method not allowed");
+            break;
+        default:
+            httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not found");
+            break;
+        }
+
+        finish(slot, metrics, start);
+        return ret;
+    }
+
+    /// One worker per unit of class limit, so every class can reach its
+    /// limit, but no more than there are sockets to serve requests on.
+    size_t asyncWorkersNeeded() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < routeCount; i++)
+        {
+            AsyncClass *cls = routeList[i].async;
+            bool seen = false;
+            for (size_t j = 0; j < i && !seen; j++)
+                seen = routeList[j].async == cls;
+            if (cls && !seen)
+                total += cls->limit;
+        }
+        if (total > settings.maxOpenSockets)
+            total = settings.maxOpenSockets;
+        return total < AsyncWorkers ? total : AsyncWorkers;
+    }
+
+    /// Hands the request to the workers and returns to httpd right away.
+    esp_err_t defer(httpd_req_t *req, RequestSlot &slot, Route *route, const RouteParams &params, int64_t start)
+    {
+        httpd_req_t *copy = nullptr;
+        if (httpd_req_async_handler_begin(req, &copy) != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Cannot defer %s", req->uri);
+            set_cors_headers(req);
+            httpd_resp_set_status(req, "503 Service Unavailable");
+            httpd_resp_set_hdr(req, "Retry-After", "1");
+            httpd_resp_send(req, nullptr, 0);
+            finish(&slot, route->metrics, start);
+            return ESP_OK;
+        }
+
+        slot.server = this;
+        slot.req = copy;
+        slot.route = route;
+        slot.start = start;
+        // Parameter values point into the URI, which the copy has its own of
+        slot.params = params;
+        for (size_t i = 0; i < params.count; i++)
+            slot.params.params[i].value = copy->uri + (params.params[i].value - req->uri);
+
+        // Cannot overflow: the queue holds as many entries as there are slots
+        slot.route->async->pending.Push((uint8_t)(&slot - slots));
+        schedule(*route->async);
+        return ESP_OK;
+    }
+
+    /// Starts queued requests of `cls` while it is under its limit. Called
+    /// after every push and every release, so no request is left waiting.
+    void schedule(AsyncClass &cls)
     {
-        set_cors_headers(req);  // Always inject CORS headers
-        auto *h = static_cast<HttpEndpoint *>(req->user_ctx);
-        return h->handle(req);
+        while (!cls.pending.IsEmpty() && cls.tryAcquire())
+        {
+            uint8_t index;
+            if (!cls.pending.Pop(index))
+            {
+                cls.release();
+                continue;
+            }
+            if (!workers.Submit(&WebServer::runDeferred, &slots[index]))
+            {
+                ESP_LOGE(TAG, "Worker queue full, running %s inline", slots[index].req->uri);
+                runDeferred(&slots[index]);
+            }
+        }
     }
 
-    static esp_err_t api_options_handler(httpd_req_t *req)
+    static void runDeferred(void *arg)
     {
+        RequestSlot &slot = *static_cast<RequestSlot *>(arg);
+        WebServer &self = *slot.server;
+        httpd_req_t *req = slot.req;
+        Route *route = slot.route;
+        int64_t start = slot.start;
+
         set_cors_headers(req);
-        httpd_resp_set_status(req, "204 No Content");
-        return httpd_resp_send(req, NULL, 0);
+        esp_err_t ret = route->handler->handle(req, slot.params);
+
+        // The slot is released here, before httpd may reuse the socket
+        httpd_handle_t hd = req->handle;
+        int fd = httpd_req_to_sockfd(req);
+        finish(&slot, route->metrics, start);
+        httpd_req_async_handler_complete(req);
+        if (ret != ESP_OK)
+            httpd_sess_trigger_close(hd, fd); // as httpd does for a failed handler
+
+        route->async->release();
+        self.schedule(*route->async);
+    }
+
+    static void finish(RequestSlot *slot, RouteMetrics &metrics, int64_t start)
+    {
+        uint16_t status = slot ? slot->status : 0;
+        uint32_t bytes = slot ? slot->bytes : 0;
+        if (slot)
+            slot->fd.store(-1, std::memory_order_release);
+        metrics.End((uint32_t)(esp_timer_get_time() - start), status, bytes);
+    }
+
+    RequestSlot *claimSlot(int fd)
+    {
+        for (RequestSlot &s : slots)
+        {
+            int expected = -1;
+            if (s.fd.compare_exchange_strong(expected, fd, std::memory_order_acquire))
+            {
+                s.status = 0;
+                s.bytes = 0;
+                return &s;
+            }
+        }
+        return nullptr;
+    }
+
+    RequestSlot *findSlot(int fd)
+    {
+        for (RequestSlot &s : slots)
+        {
+            if (s.fd.load(std::memory_order_acquire) == fd)
+                return &s;
+        }
+        return nullptr;
+    }
+
+    static esp_err_t onOpen(httpd_handle_t hd, int fd)
+    {
+        return httpd_sess_set_send_override(hd, fd, &WebServer::countingSend);
+    }
+
+    /// Same as httpd's default send, plus accounting for a dispatched request
+    /// on this socket. The first bytes of a response are its status line.
+    static int countingSend(httpd_handle_t hd, int fd, const char *buf, size_t len, int flags)
+    {
+        if (!buf)
+            return HTTPD_SOCK_ERR_INVALID;
+        int ret = send(fd, buf, len, flags);
+        if (ret < 0)
+            return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? HTTPD_SOCK_ERR_TIMEOUT : HTTPD_SOCK_ERR_FAIL;
+
+        auto *self = static_cast<WebServer *>(httpd_get_global_user_ctx(hd));
+        RequestSlot *slot = self->findSlot(fd);
+        if (slot)
+        {
+            if (slot->bytes == 0 && ret >= 12 && strncmp(buf, "HTTP/1.", 7) == 0)
+                slot->status = (uint16_t)((buf[9] - '0') * 100 + (buf[10] - '0') * 10 + (buf[11] - '0'));
+            slot->bytes += (uint32_t)ret;
+        }
+        return ret;
+    }
+
+    /// Frames are not requests and are not counted. The handshake is: httpd
+    /// has already sent the 101 when it calls us with GET, so this times the
+    /// endpoint's side of it (slot and filter setup) and counts no bytes.
+    static esp_err_t wsTrampoline(httpd_req_t *req)
+    {
+        auto *ws = static_cast<WebSocketRoute *>(req->user_ctx);
+        if (req->method != HTTP_GET)
+            return ws->handler->handle(req);
+
+        int64_t start = esp_timer_get_time();
+        ws->metrics->Begin();
+        esp_err_t ret = ws->handler->handle(req);
+        ws->metrics->End((uint32_t)(esp_timer_get_time() - start), 101, 0);
+        return ret;
     }
 };
@@ -0,0 +1,170 @@
+#pragma once
+#include "AssetIndex.h"
+#include "CachePolicy.h"
+#include "ContentEncoding.h"
+#include "esp_log.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// Read-only view of a packed asset bundle (written by pack_assets.py) in
+/// mapped memory. Little endian, offsets from the start of the image:
+///   Header   magic "FFAB", version, count, image size, build time, checksum
+///   Index    `count` Records sorted by url (strcmp order), then encoding;
+///            one per stored variant, so a url may appear up to three times
+///   Bodies   stored bytes, each BodyAlign aligned
+/// Bodies are served straight from the mapping, so a lookup hands out
+/// pointers into it; the mapping must outlive the bundle.
+class AssetBundle {
+    constexpr static const char* TAG = "AssetBundle";
+
+public:
+    static constexpr uint16_t Version = 2;
+    static constexpr size_t MaxRecords = 256;
+    static constexpr size_t BodyAlign = 16;
+
+    struct Header {
+        char magic[4];       // "FFAB"
+        uint16_t version;
+        uint16_t count;
+        uint32_t imageSize;  // header, index and bodies
+        uint32_t builtAt;    // unix time, served as Last-Modified
+        uint32_t checksum;   // FNV-1a of bytes [sizeof(Header), imageSize)
+        uint32_t reserved[3];
+    };
+
+    struct Record {
+        char url[AssetIndex::MaxUrlLength];  // "/assets/app.js", NUL padded
+        uint32_t offset;                     // of the body
+        uint32_t size;                       // stored bytes
+        uint32_t hash;                       // FNV-1a of the stored bytes
+        uint32_t encoding;                   // ContentEncoding
+    };
+
+    static_assert(sizeof(Header) == 32, "bundle header layout");
+    static_assert(sizeof(Record) == 72, "bundle record layout");
+
+    explicit AssetBundle(const CachePolicy& policy)
+        : policy(policy) {}
+
+    /// Validates the image at `data` and starts serving from it.
+    bool Attach(const uint8_t* data, size_t size) {
+        header = nullptr;
+        const Header* h = reinterpret_cast<const Header*>(data);
+        if (!data || size < sizeof(Header) || memcmp(h->magic, "FFAB", 4) != 0) {
+            ESP_LOGI(TAG, "No bundle");
+            return false;
+        }
+        if (h->version != Version || h->count > MaxRecords || h->imageSize > size ||
+            sizeof(Header) + (size_t)h->count * sizeof(Record) > h->imageSize) {
+            ESP_LOGW(TAG, "Unsupported bundle (version %u, %u files)", h->version, h->count);
+            return false;
+        }
+        if (checksum(data + sizeof(Header), h->imageSize - sizeof(Header)) != h->checksum) {
+            ESP_LOGW(TAG, "Bundle checksum mismatch, incomplete flash?");
+            return false;
+        }
+
+        const Record* r = reinterpret_cast<const Record*>(data + sizeof(Header));
+        for (size_t i = 0; i < h->count; i++) {
+            bool terminated = memchr(r[i].url, '\0', sizeof(r[i].url)) != nullptr;
+            int order = i == 0 ? -1 : strcmp(r[i - 1].url, r[i].url);
+            bool sorted = order < 0 || (order == 0 && r[i - 1].encoding < r[i].encoding);
+            if (!terminated || !sorted || r[i].encoding >= (uint32_t)ContentEncoding::Count ||
+                r[i].offset > h->imageSize || r[i].size > h->imageSize - r[i].offset) {
+                ESP_LOGW(TAG, "Corrupt bundle record %u", (unsigned)i);
+                return false;
+            }
+            // Evaluated once here, never per request
+            meta[i].mime = AssetIndex::MimeType(r[i].url);
+            meta[i].cacheControl = policy.Evaluate(r[i].url);
+        }
+
+        base = data;
+        records = r;
+        header = h;
+        ESP_LOGI(TAG, "Serving %u stored files (%lu bytes) from bundle", h->count, (unsigned long)h->imageSize);
+        return true;
+    }
+
+    bool IsAttached() const { return header != nullptr; }
+    size_t Count() const { return header ? header->count : 0; }
+
+    /// Fills `out` with every variant of `url` (query string ignored).
+    bool Find(const char* url, AssetIndex::Entry& out) const {
+        int first = indexOf(url);
+        if (first < 0)
+            return false;
+        memset(&out, 0, sizeof(out));
+        memcpy(out.url, records[first].url, sizeof(out.url));
+        out.modified = header->builtAt;
+        out.mime = meta[first].mime;
+        out.cacheControl = meta[first].cacheControl;
+        for (size_t i = first; i < header->count && strcmp(records[i].url, out.url) == 0; i++) {
+            const Record& r = records[i];
+            out.variants[r.encoding] = {r.size, r.hash};
+            out.stored |= 1u << r.encoding;
+        }
+
+        if (out.Has(ContentEncoding::Identity)) {
+            out.identitySize = out.Get(ContentEncoding::Identity).size;
+        } else if (out.Has(ContentEncoding::Gzip) && out.Get(ContentEncoding::Gzip).size >= 18) {
+            // ISIZE from the gzip trailer (RFC 1952)
+            const AssetIndex::Variant& gz = out.Get(ContentEncoding::Gzip);
+            const uint8_t* t = reinterpret_cast<const uint8_t*>(Body(out, ContentEncoding::Gzip)) + gz.size - 4;
+            out.identitySize = t[0] | t[1] << 8 | t[2] << 16 | (uint32_t)t[3] << 24;
+        }
+        return true;
+    }
+
+    /// One stored variant of an entry filled in by Find().
+    const char* Body(const AssetIndex::Entry& entry, ContentEncoding encoding) const {
+        int first = indexOf(entry.url);
+        if (first < 0)
+            return nullptr;
+        for (size_t i = first; i < header->count && strcmp(records[i].url, entry.url) == 0; i++) {
+            if (records[i].encoding == (uint32_t)encoding)
+                return reinterpret_cast<const char*>(base + records[i].offset);
+        }
+        return nullptr;
+    }
+
+private:
+    struct Meta {
+        const char* mime;
+        const char* cacheControl;
+    };
+
+    const CachePolicy& policy;
+    const uint8_t* base = nullptr;
+    const Header* header = nullptr;
+    const Record* records = nullptr;
+    Meta meta[MaxRecords];
+
+    /// First record of `url`, -1 if absent.
+    int indexOf(const char* url) const {
+        if (!header)
+            return -1;
+        size_t len = strcspn(url, "?#");
+        size_t lo = 0, hi = header->count;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            int c = strncmp(records[mid].url, url, len);
+            if (c == 0 && records[mid].url[len] != '\0')
+                c = 1;  // longer key sorts after
+            if (c < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        bool found = lo < header->count && strncmp(records[lo].url, url, len) == 0 && records[lo].url[len] == '\0';
+        return found ? (int)lo : -1;
+    }
+
+    static uint32_t checksum(const uint8_t* data, size_t len) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < len; i++)
+            hash = (hash ^ data[i]) * 16777619u;
+        return hash;
+    }
+};
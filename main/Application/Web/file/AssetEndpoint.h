@@ -0,0 +1,344 @@
+#pragma once
+#include "HttpEndpoint.h"
+#include "AssetIndex.h"
+#include "ByteRanges.h"
+#include "ContentEncoding.h"
+#include "FunctionRef.h"
+#include "GzipInflater.h"
+#include "Mutex.h"
+#include "esp_log.h"
+#include <cstring>
+#include <initializer_list>
+#include <time.h>
+
+/// HTTP semantics shared by the static asset endpoints; subclasses say where
+/// an asset's metadata and bytes come from. Unknown paths get index.html so
+/// the SPA router can handle them.
+/// The stored variant (`.br`, `.gz`, plain) is picked by `Accept-Encoding`;
+/// a client that refuses gzip outright gets the `.gz` inflated on the fly
+/// when there is no plain file, one such request at a time. Responses
+/// carry a strong ETag per variant and Last-Modified. A matching
+/// If-None-Match, or failing that an exact If-Modified-Since match, gets
+/// 304 without the body being touched. HEAD gets the full headers and no
+/// body. Cache-Control comes from the entry
+/// (see CachePolicy), so hashed bundles are not requested again at all.
+/// `Range` (honoured unless `If-Range` names another version) gets 206 with
+/// one range or multipart/byteranges with several; bodies are advertised
+/// with `Accept-Ranges: bytes`.
+class AssetEndpoint : public HttpEndpoint {
+public:
+    esp_err_t handle(httpd_req_t* req) override {
+        AssetIndex::Entry entry;
+        if (!find(req->uri, entry) && !find("/index.html", entry)) {
+            httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "File not found");
+            return ESP_FAIL;
+        }
+
+        Representation rep = negotiate(req, entry);
+        Validators v;
+        snprintf(v.etag, sizeof(v.etag), "\"%08lx-%lx%s\"", (unsigned long)rep.hash, (unsigned long)rep.size,
+                 rep.Inflated() ? "-i" : "");
+        struct tm tm;
+        gmtime_r(&entry.modified, &tm);
+        strftime(v.lastModified, sizeof(v.lastModified), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+
+        if (notModified(req, v))
+            return writeHead(req, "304 Not Modified", entry, rep, v, nullptr, -1, "");
+        if (req->method == HTTP_HEAD)
+            return writeHead(req, "200 OK", entry, rep, v, entry.mime, rep.size, "");
+
+        ByteRanges ranges;
+        switch (requestedRanges(req, rep, v, ranges)) {
+        case ByteRanges::Result::Ok:
+            return sendRanges(req, entry, rep, v, ranges);
+        case ByteRanges::Result::Unsatisfiable: {
+            char extra[48];
+            snprintf(extra, sizeof(extra), "Content-Range: bytes */%lu\r\n", (unsigned long)rep.size);
+            return writeHead(req, "416 Range Not Satisfiable", entry, rep, v, nullptr, 0, extra);
+        }
+        default:
+            break;
+        }
+        return sendFull(req, entry, rep, v);
+    }
+
+protected:
+    using Sink = FunctionRef<bool(const char*, size_t)>;
+
+    /// Looks up `url`; the query string is ignored.
+    virtual bool find(const char* url, AssetIndex::Entry& entry) const = 0;
+
+    /// Feeds bytes [first, first + length) of the stored `encoding` variant
+    /// to `sink`; fails if the source does or `sink` returns false.
+    virtual esp_err_t read(const AssetIndex::Entry& entry, ContentEncoding encoding,
+                           uint32_t first, uint32_t length, const Sink& sink) = 0;
+
+    static esp_err_t sendAll(httpd_req_t* req, const char* data, size_t len) {
+        while (len > 0) {
+            int sent = httpd_send(req, data, len);
+            if (sent <= 0)
+                return ESP_FAIL;
+            data += sent;
+            len -= sent;
+        }
+        return ESP_OK;
+    }
+
+private:
+    static constexpr const char* Boundary = "FIREFLY_BYTERANGES";
+
+    // Held by the one request inflating, across every asset endpoint
+    static inline Mutex inflating;
+
+    /// What goes on the wire for one request.
+    struct Representation {
+        ContentEncoding stored;  // variant read from the source
+        ContentEncoding sent;    // Content-Encoding; identity when inflating
+        uint32_t size;           // full body as sent
+        uint32_t hash;           // of the stored variant
+        bool vary;               // another Accept-Encoding could get other bytes
+
+        bool Inflated() const { return stored != sent; }
+    };
+
+    struct Validators {
+        char etag[28];
+        char lastModified[32];
+    };
+
+    /// Best stored variant by the client's quality, ties going to the
+    /// smaller coding. If nothing stored is acceptable, the `.gz` is
+    /// inflated for a client that refuses gzip and takes identity. Anyone
+    /// else gets the `.gz` when there is one (inflating costs a 32 KB
+    /// window and the CPU for the whole body), else whatever is stored.
+    static Representation negotiate(httpd_req_t* req, const AssetIndex::Entry& entry) {
+        AcceptEncoding accept;
+        char value[96];
+        esp_err_t err = httpd_req_get_hdr_value_str(req, "Accept-Encoding", value, sizeof(value));
+        if (err == ESP_OK || err == ESP_ERR_HTTPD_RESULT_TRUNC)
+            accept.Parse(value);
+
+        static constexpr ContentEncoding preference[] = {ContentEncoding::Brotli, ContentEncoding::Gzip,
+                                                         ContentEncoding::Identity};
+        ContentEncoding stored = ContentEncoding::Count;
+        ContentEncoding sent = ContentEncoding::Count;
+        uint16_t best = 0;
+        for (ContentEncoding e : preference) {
+            if (entry.Has(e) && accept.Quality(e) > best) {
+                stored = sent = e;
+                best = accept.Quality(e);
+            }
+        }
+        bool inflatable = !entry.Has(ContentEncoding::Identity) && entry.Has(ContentEncoding::Gzip);
+        if (stored == ContentEncoding::Count && inflatable && accept.Refuses(ContentEncoding::Gzip) &&
+            accept.Accepts(ContentEncoding::Identity)) {
+            stored = ContentEncoding::Gzip;
+            sent = ContentEncoding::Identity;
+        }
+        if (stored == ContentEncoding::Count) {
+            for (ContentEncoding e : {ContentEncoding::Gzip, ContentEncoding::Identity, ContentEncoding::Brotli}) {
+                if (entry.Has(e)) {
+                    stored = sent = e;
+                    break;
+                }
+            }
+        }
+
+        const AssetIndex::Variant& variant = entry.Get(stored);
+        bool compressed = entry.stored & ~(1u << (size_t)ContentEncoding::Identity);
+        return {stored, sent, stored == sent ? variant.size : entry.identitySize, variant.hash, compressed};
+    }
+
+    /// If-None-Match wins when present (RFC 9110 13.2.2); If-Modified-Since
+    /// is compared as a string, as browsers echo our Last-Modified back.
+    static bool notModified(httpd_req_t* req, const Validators& v) {
+        char value[128];
+        esp_err_t err = httpd_req_get_hdr_value_str(req, "If-None-Match", value, sizeof(value));
+        if (err == ESP_OK || err == ESP_ERR_HTTPD_RESULT_TRUNC)
+            return listContains(value, v.etag);
+
+        if (httpd_req_get_hdr_value_str(req, "If-Modified-Since", value, sizeof(value)) == ESP_OK)
+            return strcmp(value, v.lastModified) == 0;
+        return false;
+    }
+
+    /// `"a", W/"b"` style list; weak comparison, `*` matches anything.
+    static bool listContains(const char* list, const char* etag) {
+        size_t etagLen = strlen(etag);
+        const char* p = list;
+        while (*p) {
+            while (*p == ' ' || *p == ',')
+                p++;
+            if (*p == '*')
+                return true;
+            if (strncmp(p, "W/", 2) == 0)
+                p += 2;
+            size_t len = strcspn(p, ",");
+            while (len > 0 && p[len - 1] == ' ')
+                len--;
+            if (len == etagLen && strncmp(p, etag, len) == 0)
+                return true;
+            p += strcspn(p, ",");
+        }
+        return false;
+    }
+
+    /// Parses Range unless If-Range names a different version. Inflated
+    /// bodies cannot be entered halfway, and several ranges of a compressed
+    /// body are not offered: the multipart wrapper would have to sit inside
+    /// the Content-Encoding.
+    static ByteRanges::Result requestedRanges(httpd_req_t* req, const Representation& rep,
+                                              const Validators& v, ByteRanges& ranges) {
+        char value[96];
+        if (rep.Inflated() || httpd_req_get_hdr_value_str(req, "Range", value, sizeof(value)) != ESP_OK)
+            return ByteRanges::Result::Ignore;
+
+        char ifRange[40];
+        if (httpd_req_get_hdr_value_str(req, "If-Range", ifRange, sizeof(ifRange)) == ESP_OK &&
+            strcmp(ifRange, v.etag) != 0 && strcmp(ifRange, v.lastModified) != 0)
+            return ByteRanges::Result::Ignore;
+
+        ByteRanges::Result result = ranges.Parse(value, rep.size);
+        if (result == ByteRanges::Result::Ok && ranges.count > 1 && rep.sent != ContentEncoding::Identity)
+            return ByteRanges::Result::Ignore;
+        return result;
+    }
+
+    /// Writes the status line and headers directly, so every response,
+    /// 200 included, goes out with an exact Content-Length and no chunking.
+    /// `contentType` null leaves out the entity headers; `contentLength`
+    /// < 0 leaves out Content-Length.
+    esp_err_t writeHead(httpd_req_t* req, const char* status, const AssetIndex::Entry& entry,
+                        const Representation& rep, const Validators& v, const char* contentType,
+                        int64_t contentLength, const char* extra) {
+        char hdr[480];
+        int len = snprintf(hdr, sizeof(hdr),
+            "HTTP/1.1 %s\r\n"
+            "Access-Control-Allow-Origin: *\r\n"
+            "ETag: %s\r\n"
+            "Last-Modified: %s\r\n"
+            "Cache-Control: %s\r\n"
+            "Accept-Ranges: bytes\r\n"
+            "%s"
+            "%s",
+            status, v.etag, v.lastModified, entry.cacheControl,
+            rep.vary ? "Vary: Accept-Encoding\r\n" : "", extra);
+        const char* encoding = ContentEncodingName(rep.sent);
+        if (contentType) {
+            len += snprintf(hdr + len, sizeof(hdr) - len, "Content-Type: %s\r\n", contentType);
+            if (encoding && contentType == entry.mime)
+                len += snprintf(hdr + len, sizeof(hdr) - len, "Content-Encoding: %s\r\n", encoding);
+        }
+        if (contentLength >= 0)
+            len += snprintf(hdr + len, sizeof(hdr) - len, "Content-Length: %lu\r\n", (unsigned long)contentLength);
+        len += snprintf(hdr + len, sizeof(hdr) - len, "\r\n");
+        if (len >= (int)sizeof(hdr))
+            return ESP_FAIL;
+        return sendAll(req, hdr, len);
+    }
+
+    /// 200 with the whole body. The head goes out with the first bytes, so
+    /// a source that fails before producing any still gets a proper 500.
+    esp_err_t sendFull(httpd_req_t* req, const AssetIndex::Entry& entry, const Representation& rep,
+                       const Validators& v) {
+        bool headSent = false;
+        auto send = [&](const char* data, size_t len) {
+            if (!headSent) {
+                if (writeHead(req, "200 OK", entry, rep, v, entry.mime, rep.size, "") != ESP_OK)
+                    return false;
+                headSent = true;
+            }
+            return sendAll(req, data, len) == ESP_OK;
+        };
+
+        esp_err_t ret;
+        const AssetIndex::Variant& stored = entry.Get(rep.stored);
+        if (rep.Inflated()) {
+            if (!inflating.Take(0))
+                return busy(req);
+            {
+                GzipInflater inflater(send);
+                if (!inflater.IsReady()) {
+                    inflating.Give();
+                    return busy(req);
+                }
+                ret = read(entry, rep.stored, 0, stored.size, [&](const char* data, size_t len) {
+                    return inflater.Feed(data, len);
+                });
+                if (ret == ESP_OK && !inflater.Finish())
+                    ret = ESP_FAIL;
+            }
+            inflating.Give();
+        } else {
+            ret = read(entry, rep.stored, 0, stored.size, send);
+        }
+
+        if (!headSent) {
+            if (ret == ESP_ERR_TIMEOUT)
+                return busy(req);  // the source was busy, not broken
+            if (ret != ESP_OK) {
+                httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Read failed");
+                return ESP_FAIL;
+            }
+            ret = writeHead(req, "200 OK", entry, rep, v, entry.mime, rep.size, "");  // empty body
+        }
+        return ret;
+    }
+
+    /// 503 for a body that cannot be produced right now: an inflation
+    /// already runs or has no heap, or the source timed out.
+    static esp_err_t busy(httpd_req_t* req) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        return httpd_resp_send(req, nullptr, 0);
+    }
+
+    static int partHeader(char* buf, size_t size, const AssetIndex::Entry& entry, const Representation& rep,
+                          const ByteRanges::Range& r) {
+        return snprintf(buf, size,
+            "\r\n--%s\r\n"
+            "Content-Type: %s\r\n"
+            "Content-Range: bytes %lu-%lu/%lu\r\n\r\n",
+            Boundary, entry.mime, (unsigned long)r.first, (unsigned long)r.last, (unsigned long)rep.size);
+    }
+
+    esp_err_t sendRanges(httpd_req_t* req, const AssetIndex::Entry& entry, const Representation& rep,
+                         const Validators& v, const ByteRanges& ranges) {
+        // The length is already promised: on failure the connection is dropped
+        auto send = [req](const char* data, size_t len) {
+            return sendAll(req, data, len) == ESP_OK;
+        };
+
+        char part[160];
+        if (ranges.count == 1) {
+            const ByteRanges::Range& r = ranges.ranges[0];
+            snprintf(part, sizeof(part), "Content-Range: bytes %lu-%lu/%lu\r\n",
+                     (unsigned long)r.first, (unsigned long)r.last, (unsigned long)rep.size);
+            esp_err_t ret = writeHead(req, "206 Partial Content", entry, rep, v, entry.mime, r.Length(), part);
+            if (ret == ESP_OK)
+                ret = read(entry, rep.stored, r.first, r.Length(), send);
+            return ret;
+        }
+
+        // Content-Length covers every part header, body and the trailer
+        const char* trailerFmt = "\r\n--%s--\r\n";
+        int64_t total = snprintf(nullptr, 0, trailerFmt, Boundary);
+        for (size_t i = 0; i < ranges.count; i++)
+            total += partHeader(part, sizeof(part), entry, rep, ranges.ranges[i]) + ranges.ranges[i].Length();
+
+        char contentType[64];
+        snprintf(contentType, sizeof(contentType), "multipart/byteranges; boundary=%s", Boundary);
+        esp_err_t ret = writeHead(req, "206 Partial Content", entry, rep, v, contentType, total, "");
+        for (size_t i = 0; i < ranges.count && ret == ESP_OK; i++) {
+            int len = partHeader(part, sizeof(part), entry, rep, ranges.ranges[i]);
+            ret = sendAll(req, part, len);
+            if (ret == ESP_OK)
+                ret = read(entry, rep.stored, ranges.ranges[i].first, ranges.ranges[i].Length(), send);
+        }
+        if (ret == ESP_OK) {
+            int len = snprintf(part, sizeof(part), trailerFmt, Boundary);
+            ret = sendAll(req, part, len);
+        }
+        return ret;
+    }
+};
@@ -0,0 +1,397 @@
+#pragma once
+#include "CachePolicy.h"
+#include "ContentEncoding.h"
+#include "Mutex.h"
+#include "ContextLock.h"
+#include "esp_log.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/// In-RAM index of the files under the web root, keyed by URL path.
+/// Built once at boot by walking the tree and refreshed per path when a file
+/// changes, so serving a request costs one binary search and no filesystem
+/// metadata calls. `x`, `x.gz` and `x.br` are stored variants of one URL;
+/// a walk merges each file it meets into its URL's entry, so every stored
+/// file is stat'ed and hashed once.
+class AssetIndex {
+    constexpr static const char* TAG = "AssetIndex";
+
+public:
+    static constexpr size_t MaxAssets = 128;
+    static constexpr size_t MaxUrlLength = 56;
+    static constexpr size_t MaxPathLength = 128;
+
+    struct Variant {
+        uint32_t size;  // bytes on disk
+        uint32_t hash;  // FNV-1a of the stored bytes
+    };
+
+    struct Entry {
+        char url[MaxUrlLength];  // "/assets/app.js", without ".gz" or ".br"
+        Variant variants[(size_t)ContentEncoding::Count];
+        uint8_t stored;          // bit per ContentEncoding present
+        uint8_t generation;      // walk that last filled it
+        uint32_t identitySize;   // plain size, from the gzip trailer if only compressed
+        time_t modified;         // newest variant
+        const char* mime;
+        const char* cacheControl;
+
+        bool Has(ContentEncoding e) const { return stored & (1u << (size_t)e); }
+        const Variant& Get(ContentEncoding e) const { return variants[(size_t)e]; }
+    };
+
+    AssetIndex(const char* basePath, const CachePolicy& policy)
+        : basePath(basePath), policy(policy) {}
+
+    /// Walks the whole tree. Call once before serving.
+    void Build() {
+        {
+            LOCK(mutex);
+            count = 0;
+        }
+        char dir[MaxPathLength];
+        snprintf(dir, sizeof(dir), "%s", basePath);
+        walk(dir, "/");
+        ESP_LOGI(TAG, "Indexed %u assets under %s", (unsigned)count, basePath);
+    }
+
+    /// Re-evaluates one changed path (file or directory, absolute or
+    /// relative to the web root), e.g. after an FTP upload or delete.
+    void Refresh(const char* path) {
+        size_t baseLen = strlen(basePath);
+        if (strncmp(path, basePath, baseLen) == 0)
+            path += baseLen;
+
+        char url[MaxUrlLength];
+        if (!toUrl(path, url, sizeof(url)))
+            return;
+
+        char full[MaxPathLength];
+        snprintf(full, sizeof(full), "%s%s", basePath, url);
+        struct stat st;
+        if (stat(full, &st) == 0 && S_ISDIR(st.st_mode)) {
+            walk(full, url);
+            return;
+        }
+
+        Entry entry;
+        if (load(url, entry))
+            upsert(entry);
+        else
+            removePrefix(url); // a removed directory takes its files with it
+    }
+
+    /// Copies the entry for `url` (query string ignored) into `out`.
+    bool Find(const char* url, Entry& out) const {
+        size_t len = strcspn(url, "?#");
+        LOCK(mutex);
+        size_t i = lowerBound(url, len);
+        if (i < count && compare(entries[i].url, url, len) == 0) {
+            out = entries[i];
+            return true;
+        }
+        return false;
+    }
+
+    /// Full filesystem path of one of an entry's stored files.
+    void PathOf(const Entry& entry, ContentEncoding encoding, char* out, size_t outSize) const {
+        snprintf(out, outSize, "%s%s%s", basePath, entry.url, ContentEncodingExtension(encoding));
+    }
+
+    size_t Count() const { return count; }
+
+    static const char* MimeType(const char* url) {
+        static constexpr struct {
+            const char* ext;
+            const char* type;
+        } types[] = {
+            {"html", "text/html"},
+            {"js", "application/javascript"},
+            {"mjs", "application/javascript"},
+            {"css", "text/css"},
+            {"json", "application/json"},
+            {"map", "application/json"},
+            {"webmanifest", "application/manifest+json"},
+            {"png", "image/png"},
+            {"jpg", "image/jpeg"},
+            {"jpeg", "image/jpeg"},
+            {"gif", "image/gif"},
+            {"ico", "image/x-icon"},
+            {"svg", "image/svg+xml"},
+            {"webp", "image/webp"},
+            {"woff", "font/woff"},
+            {"woff2", "font/woff2"},
+            {"ttf", "font/ttf"},
+            {"txt", "text/plain"},
+        };
+
+        const char* slash = strrchr(url, '/');
+        const char* dot = strrchr(slash ? slash : url, '.');
+        if (dot) {
+            for (const auto& t : types) {
+                if (strcasecmp(dot + 1, t.ext) == 0)
+                    return t.type;
+            }
+        }
+        return "text/plain";
+    }
+
+private:
+    const char* basePath;
+    const CachePolicy& policy;
+    mutable Mutex mutex;
+    Entry entries[MaxAssets];
+    size_t count = 0;
+    uint8_t generation = 0;
+
+    /// `dir//name.js.gz` -> `/dir/name.js`
+    static bool toUrl(const char* relPath, char* url, size_t urlSize) {
+        size_t len = strlen(relPath);
+        if (len > 3 && (strcmp(relPath + len - 3, ".gz") == 0 || strcmp(relPath + len - 3, ".br") == 0))
+            len -= 3;
+
+        size_t out = 0;
+        url[out++] = '/';
+        for (size_t i = 0; i < len; i++) {
+            if (relPath[i] == '/' && url[out - 1] == '/')
+                continue;
+            if (out + 1 >= urlSize) {
+                ESP_LOGW(TAG, "Path too long to index: %s", relPath);
+                return false;
+            }
+            url[out++] = relPath[i];
+        }
+        if (out > 1 && url[out - 1] == '/')
+            out--;
+        url[out] = '\0';
+        return true;
+    }
+
+    /// Fills `entry` for `url` from whichever variants are on disk.
+    bool load(const char* url, Entry& entry) const {
+        memset(&entry, 0, sizeof(entry));
+        char path[MaxPathLength];
+        struct stat st;
+        for (size_t i = 0; i < (size_t)ContentEncoding::Count; i++) {
+            snprintf(path, sizeof(path), "%s%s%s", basePath, url, ContentEncodingExtension((ContentEncoding)i));
+            if (stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+                continue;
+            Stored file;
+            if (!readStored(path, st, file))
+                return false;
+            merge(entry, (ContentEncoding)i, file);
+        }
+        if (!entry.stored)
+            return false;
+
+        initEntry(entry, url);
+        return true;
+    }
+
+    /// What reading one stored file yields.
+    struct Stored {
+        Variant variant;
+        time_t modified;
+        uint32_t tail; // last four bytes, little endian: gzip's ISIZE
+    };
+
+    /// Hashes the file; the trailer comes along from the same read.
+    static bool readStored(const char* path, const struct stat& st, Stored& out) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        uint32_t hash = 2166136261u;
+        uint32_t tail = 0;
+        uint8_t buf[256];
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) {
+            for (ssize_t i = 0; i < n; i++) {
+                hash = (hash ^ buf[i]) * 16777619u;
+                tail = tail >> 8 | (uint32_t)buf[i] << 24;
+            }
+        }
+        close(fd);
+        out.variant = {(uint32_t)st.st_size, hash};
+        out.modified = st.st_mtime;
+        out.tail = tail;
+        return n == 0;
+    }
+
+    void initEntry(Entry& entry, const char* url) const {
+        strncpy(entry.url, url, sizeof(entry.url));
+        entry.url[sizeof(entry.url) - 1] = '\0';
+        entry.mime = MimeType(url);
+        entry.cacheControl = policy.Evaluate(url);
+    }
+
+    /// Adds one stored variant; the result does not depend on the order
+    /// variants arrive in.
+    static void merge(Entry& entry, ContentEncoding encoding, const Stored& file) {
+        size_t i = (size_t)encoding;
+        entry.variants[i] = file.variant;
+        entry.stored |= 1u << i;
+        if (file.modified > entry.modified)
+            entry.modified = file.modified;
+        if (encoding == ContentEncoding::Identity)
+            entry.identitySize = file.variant.size;
+        else if (encoding == ContentEncoding::Gzip && !entry.Has(ContentEncoding::Identity))
+            entry.identitySize = file.variant.size >= 18 ? file.tail : 0; // ISIZE (RFC 1952)
+    }
+
+    static ContentEncoding encodingOf(const char* path) {
+        size_t len = strlen(path);
+        for (size_t i = 1; i < (size_t)ContentEncoding::Count; i++) {
+            const char* ext = ContentEncodingExtension((ContentEncoding)i);
+            size_t extLen = strlen(ext);
+            if (len > extLen && strcmp(path + len - extLen, ext) == 0)
+                return (ContentEncoding)i;
+        }
+        return ContentEncoding::Identity;
+    }
+
+    /// Indexes every file below `dir` (whose URL is `url`), then drops
+    /// entries under it that no longer have a file. `dir` is scratch space.
+    void walk(char* dir, const char* url) {
+        {
+            LOCK(mutex);
+            generation++;
+            // Everything below is unseen, whichever walk last filled it
+            for (size_t i = 0; i < count; i++) {
+                if (isUnder(entries[i].url, url))
+                    entries[i].generation = generation - 1;
+            }
+        }
+        scan(dir);
+        removeStale(url);
+    }
+
+    /// Indexes every file below `dir`; `dir` is used as scratch space.
+    void scan(char* dir) {
+        DIR* d = opendir(dir);
+        if (!d)
+            return;
+
+        size_t dirLen = strlen(dir);
+        size_t baseLen = strlen(basePath);
+        struct dirent* e;
+        while ((e = readdir(d)) != nullptr) {
+            if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+                continue;
+            if (snprintf(dir + dirLen, MaxPathLength - dirLen, "/%s", e->d_name) >= (int)(MaxPathLength - dirLen))
+                continue;
+
+            if (e->d_type == DT_DIR)
+                scan(dir);
+            else
+                add(dir, dir + baseLen);
+            dir[dirLen] = '\0';
+        }
+        closedir(d);
+    }
+
+    /// Reads one stored file and merges it into its URL's entry.
+    void add(const char* path, const char* relPath) {
+        char url[MaxUrlLength];
+        struct stat st;
+        Stored file;
+        if (!toUrl(relPath, url, sizeof(url)) || stat(path, &st) != 0 || !S_ISREG(st.st_mode) ||
+            !readStored(path, st, file))
+            return;
+
+        LOCK(mutex);
+        size_t len = strlen(url);
+        size_t i = lowerBound(url, len);
+        if (i == count || compare(entries[i].url, url, len) != 0) {
+            if (count == MaxAssets) {
+                ESP_LOGW(TAG, "Index full, not serving %s", url);
+                return;
+            }
+            memmove(&entries[i + 1], &entries[i], (count - i) * sizeof(Entry));
+            count++;
+            memset(&entries[i], 0, sizeof(Entry));
+            initEntry(entries[i], url);
+            entries[i].generation = generation;
+        } else if (entries[i].generation != generation) {
+            // First variant seen by this walk: forget what the last one found
+            Entry& entry = entries[i];
+            memset(entry.variants, 0, sizeof(entry.variants));
+            entry.stored = 0;
+            entry.modified = 0;
+            entry.identitySize = 0;
+            entry.generation = generation;
+        }
+        merge(entries[i], encodingOf(relPath), file);
+    }
+
+    static int compare(const char* key, const char* url, size_t len) {
+        int c = strncmp(key, url, len);
+        if (c != 0)
+            return c;
+        return key[len] == '\0' ? 0 : 1;
+    }
+
+    size_t lowerBound(const char* url, size_t len) const {
+        size_t lo = 0, hi = count;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (compare(entries[mid].url, url, len) < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    void upsert(const Entry& entry) {
+        LOCK(mutex);
+        size_t len = strlen(entry.url);
+        size_t i = lowerBound(entry.url, len);
+        if (i < count && compare(entries[i].url, entry.url, len) == 0) {
+            entries[i] = entry;
+            return;
+        }
+        if (count == MaxAssets) {
+            ESP_LOGW(TAG, "Index full, not serving %s", entry.url);
+            return;
+        }
+        memmove(&entries[i + 1], &entries[i], (count - i) * sizeof(Entry));
+        entries[i] = entry;
+        count++;
+    }
+
+    /// Drops `url` and everything below it.
+    void removePrefix(const char* url) {
+        LOCK(mutex);
+        removeIf(url, [](const Entry&) { return true; });
+    }
+
+    /// Drops entries below `url` that the current walk did not find.
+    void removeStale(const char* url) {
+        LOCK(mutex);
+        removeIf(url, [this](const Entry& e) { return e.generation != generation; });
+    }
+
+    /// Caller holds mutex.
+    template <typename PRED>
+    void removeIf(const char* url, PRED pred) {
+        size_t out = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!isUnder(entries[i].url, url) || !pred(entries[i]))
+                entries[out++] = entries[i];
+        }
+        count = out;
+    }
+
+    /// `key` is `url` or below it; "/" covers the whole index.
+    static bool isUnder(const char* key, const char* url) {
+        size_t len = strcmp(url, "/") == 0 ? 0 : strlen(url);
+        return strncmp(key, url, len) == 0 && (key[len] == '\0' || key[len] == '/');
+    }
+};
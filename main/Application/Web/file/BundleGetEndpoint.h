@@ -0,0 +1,38 @@
+#pragma once
+#include "AssetEndpoint.h"
+#include "AssetBundle.h"
+#include "FileGetEndpoint.h"
+
+/// Serves the UI from a mapped AssetBundle: bodies are handed to the socket
+/// straight from flash, with no filesystem and no intermediate buffer.
+/// Paths the bundle lacks but the FAT partition has (uploads over FTP) are
+/// passed to `files`; only then does the SPA fallback to index.html apply.
+class BundleGetEndpoint : public AssetEndpoint {
+public:
+    BundleGetEndpoint(const AssetBundle& bundle, FileGetEndpoint& files)
+        : bundle(bundle), files(files) {}
+
+    esp_err_t handle(httpd_req_t* req) override {
+        AssetIndex::Entry entry;
+        if (!bundle.Find(req->uri, entry) && files.Has(req->uri))
+            return files.handle(req);
+        return AssetEndpoint::handle(req);
+    }
+
+protected:
+    bool find(const char* url, AssetIndex::Entry& entry) const override {
+        return bundle.Find(url, entry);
+    }
+
+    esp_err_t read(const AssetIndex::Entry& entry, ContentEncoding encoding,
+                   uint32_t first, uint32_t length, const Sink& sink) override {
+        const char* body = bundle.Body(entry, encoding);
+        if (!body)
+            return ESP_FAIL;
+        return sink(body + first, length) ? ESP_OK : ESP_FAIL;
+    }
+
+private:
+    const AssetBundle& bundle;
+    FileGetEndpoint& files;
+};
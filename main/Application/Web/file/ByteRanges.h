@@ -0,0 +1,92 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Parsed `Range: bytes=...` header for a representation of known size.
+/// Ranges keep request order and are clipped to the size; overlapping
+/// ranges are served as asked.
+struct ByteRanges {
+    static constexpr size_t MaxRanges = 4;
+
+    enum class Result {
+        Ok,             // `count` satisfiable ranges
+        Ignore,         // malformed, other unit or too many: serve the full body
+        Unsatisfiable,  // valid but none overlaps the body: 416
+    };
+
+    struct Range {
+        uint32_t first;
+        uint32_t last;  // inclusive
+
+        uint32_t Length() const { return last - first + 1; }
+    };
+
+    Range ranges[MaxRanges];
+    size_t count = 0;
+
+    /// RFC 9110 14.1.1: `bytes=` then a comma-separated list of
+    /// `first-last`, `first-` or `-suffix`, digits only, with optional spaces
+    /// around the commas. Anything else makes the whole header Ignore.
+    Result Parse(const char* header, uint32_t size) {
+        count = 0;
+        if (strncmp(header, "bytes=", 6) != 0)
+            return Result::Ignore;
+
+        const char* p = header + 6;
+        bool any = false;
+        while (*p) {
+            while (*p == ' ' || *p == '\t' || *p == ',')
+                p++;
+            if (!*p)
+                break;
+
+            unsigned long first = 0;
+            unsigned long last = 0;
+            bool hasFirst = number(p, first);
+            if (*p++ != '-')
+                return Result::Ignore;
+            bool hasLast = number(p, last);
+            while (*p == ' ' || *p == '\t')
+                p++;
+            if ((*p && *p != ',') || (!hasFirst && !hasLast) || (hasFirst && hasLast && last < first))
+                return Result::Ignore;
+            any = true;
+
+            Range r;
+            if (!hasFirst) {
+                // suffix: the last N bytes
+                if (last == 0 || size == 0)
+                    continue;
+                r.first = last >= size ? 0 : size - (uint32_t)last;
+                r.last = size - 1;
+            } else {
+                if (first >= size)
+                    continue;
+                r.first = (uint32_t)first;
+                r.last = !hasLast || last >= size ? size - 1 : (uint32_t)last;
+            }
+
+            if (count == MaxRanges)
+                return Result::Ignore;
+            ranges[count++] = r;
+        }
+
+        if (!any)
+            return Result::Ignore;
+        return count ? Result::Ok : Result::Unsatisfiable;
+    }
+
+private:
+    /// Reads a run of digits; false (and `p` unmoved) if there is none.
+    /// Values past ULONG_MAX saturate, which clips like any oversized value.
+    static bool number(const char*& p, unsigned long& v) {
+        if (*p < '0' || *p > '9')
+            return false;
+        char* end;
+        v = strtoul(p, &end, 10);
+        p = end;
+        return true;
+    }
+};
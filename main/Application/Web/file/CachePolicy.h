@@ -0,0 +1,119 @@
+#pragma once
+#include "esp_log.h"
+#include <ctype.h>
+#include <stddef.h>
+#include <string.h>
+
+/// Picks the Cache-Control value for an asset URL. Evaluated once per file
+/// when the AssetIndex (re)loads it, never per request.
+/// Rules added with AddRule() are tried first, in order; then content-hashed
+/// bundler output (`/assets/index-B3f9a1cZ.js`, `/assets/app.3f9a1c7b.css`)
+/// is immutable for a year and everything else, index.html included, must
+/// revalidate.
+class CachePolicy {
+    constexpr static const char* TAG = "CachePolicy";
+
+public:
+    static constexpr size_t MaxRules = 8;
+    static constexpr const char* Immutable = "public, max-age=31536000, immutable";
+    static constexpr const char* Revalidate = "no-cache";
+
+    /// `glob`: `*` matches within one path segment, `**` across segments,
+    /// `?` one character. `value` must outlive the policy.
+    bool AddRule(const char* glob, const char* value) {
+        if (count == MaxRules) {
+            ESP_LOGW(TAG, "Too many rules, ignoring %s", glob);
+            return false;
+        }
+        rules[count++] = {glob, value};
+        return true;
+    }
+
+    const char* Evaluate(const char* url) const {
+        for (size_t i = 0; i < count; i++) {
+            if (Match(rules[i].glob, url))
+                return rules[i].value;
+        }
+        return IsContentHashed(url) ? Immutable : Revalidate;
+    }
+
+    static bool Match(const char* glob, const char* s) {
+        while (*glob) {
+            if (glob[0] == '*') {
+                bool crossSegments = glob[1] == '*';
+                glob += crossSegments ? 2 : 1;
+                for (const char* t = s;; t++) {
+                    if (Match(glob, t))
+                        return true;
+                    if (*t == '\0' || (!crossSegments && *t == '/'))
+                        return false;
+                }
+            }
+            if (*s == '\0' || (*glob != '?' && *glob != *s))
+                return false;
+            glob++;
+            s++;
+        }
+        return *s == '\0';
+    }
+
+    /// Bundler output under /assets/: Vite/Rollup's `name-HASH.ext` with the
+    /// 8-character base64url hash, or webpack's `name.HASH.ext` with 8 to 20
+    /// lower-case hex digits. One more suffix may follow the hash
+    /// (`.js.map`, `.chunk.js`). The hash must mix letters and digits, so
+    /// dates, build numbers and plain words never qualify. Other layouts
+    /// need a rule; a miss only costs a revalidation.
+    static bool IsContentHashed(const char* url) {
+        static constexpr char Dir[] = "/assets/";
+        if (strncmp(url, Dir, sizeof(Dir) - 1) != 0)
+            return false;
+        const char* name = strrchr(url, '/') + 1;
+
+        const char* ext = strrchr(name, '.');
+        for (int suffixes = 0; ext && suffixes < 2; suffixes++) {
+            if (hasHash(name, ext, 8, '-', isBase64Url))
+                return true;
+            for (size_t len = 8; len <= 20; len++) {
+                if (hasHash(name, ext, len, '.', isHex))
+                    return true;
+            }
+            while (--ext > name && *ext != '.') {
+            }
+            if (ext == name)
+                ext = nullptr;
+        }
+        return false;
+    }
+
+private:
+    static bool isBase64Url(char c) { return isalnum((unsigned char)c) || c == '_' || c == '-'; }
+    static bool isHex(char c) { return isxdigit((unsigned char)c) && !isupper((unsigned char)c); }
+
+    /// The `len` characters before `ext` follow `sep` and are all `valid`,
+    /// with at least one letter and one digit.
+    template <typename VALID>
+    static bool hasHash(const char* name, const char* ext, size_t len, char sep, VALID valid) {
+        if (ext - name <= (ptrdiff_t)len)
+            return false;
+        const char* hash = ext - len;
+        if (hash[-1] != sep)
+            return false;
+        bool digit = false;
+        bool letter = false;
+        for (const char* c = hash; c < ext; c++) {
+            if (!valid(*c))
+                return false;
+            digit |= isdigit((unsigned char)*c) != 0;
+            letter |= isalpha((unsigned char)*c) != 0;
+        }
+        return digit && letter;
+    }
+
+    struct Rule {
+        const char* glob;
+        const char* value;
+    };
+
+    Rule rules[MaxRules];
+    size_t count = 0;
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/// Content codings an asset can be stored in, in server preference order
+/// (smallest first) for equally acceptable codings.
+enum class ContentEncoding : uint8_t {
+    Identity,
+    Gzip,
+    Brotli,
+    Count
+};
+
+/// Token for Content-Encoding, null for identity.
+inline const char* ContentEncodingName(ContentEncoding e) {
+    switch (e) {
+    case ContentEncoding::Gzip:
+        return "gzip";
+    case ContentEncoding::Brotli:
+        return "br";
+    default:
+        return nullptr;
+    }
+}
+
+/// File name suffix of a stored variant.
+inline const char* ContentEncodingExtension(ContentEncoding e) {
+    switch (e) {
+    case ContentEncoding::Gzip:
+        return ".gz";
+    case ContentEncoding::Brotli:
+        return ".br";
+    default:
+        return "";
+    }
+}
+
+/// Parsed `Accept-Encoding`: a quality (0 to 1000) per coding. Unlisted
+/// codings take the `*` quality; without `*`, identity stays acceptable
+/// (RFC 9110 12.5.3), though below any coding the client did list.
+/// A request without the header takes gzip as well as identity; brotli
+/// is left to clients that name it. A coding is refused only when the
+/// header gives it, or `*` with it unlisted, `q=0`.
+class AcceptEncoding {
+public:
+    AcceptEncoding() {
+        quality[(size_t)ContentEncoding::Identity] = 1000;
+        quality[(size_t)ContentEncoding::Gzip] = 1000;
+    }
+
+    void Parse(const char* header) {
+        int16_t listed[(size_t)ContentEncoding::Count] = {-1, -1, -1};
+        int16_t star = -1;
+
+        const char* p = header;
+        while (*p) {
+            while (*p == ' ' || *p == ',')
+                p++;
+            size_t len = strcspn(p, ",; ");
+            if (len == 0)
+                break;
+            const char* token = p;
+            p += len;
+
+            int16_t q = 1000;
+            const char* params = p;
+            p += strcspn(p, ",");
+            const char* qp = strstr(params, "q=");
+            if (qp && qp < p)
+                q = parseQuality(qp + 2);
+
+            if (len == 1 && *token == '*')
+                star = q;
+            else if (is(token, len, "gzip") || is(token, len, "x-gzip"))
+                listed[(size_t)ContentEncoding::Gzip] = q;
+            else if (is(token, len, "br"))
+                listed[(size_t)ContentEncoding::Brotli] = q;
+            else if (is(token, len, "identity"))
+                listed[(size_t)ContentEncoding::Identity] = q;
+        }
+
+        refused = 0;
+        for (size_t i = 0; i < (size_t)ContentEncoding::Count; i++) {
+            int16_t unlisted = i == (size_t)ContentEncoding::Identity ? 1 : 0;
+            int16_t given = listed[i] >= 0 ? listed[i] : star;
+            quality[i] = given >= 0 ? given : unlisted;
+            if (given == 0)
+                refused |= 1u << i;
+        }
+    }
+
+    uint16_t Quality(ContentEncoding e) const { return quality[(size_t)e]; }
+    bool Accepts(ContentEncoding e) const { return Quality(e) > 0; }
+    bool Refuses(ContentEncoding e) const { return refused & (1u << (size_t)e); }
+
+private:
+    uint16_t quality[(size_t)ContentEncoding::Count] = {};
+    uint8_t refused = 0;  // bit per coding given q=0
+
+    static bool is(const char* token, size_t len, const char* name) {
+        return strlen(name) == len && strncasecmp(token, name, len) == 0;
+    }
+
+    /// "0.8" -> 800, clamped to [0, 1000]
+    static int16_t parseQuality(const char* s) {
+        double q = strtod(s, nullptr);
+        if (q <= 0)
+            return 0;
+        return q >= 1 ? 1000 : (int16_t)(q * 1000 + 0.5);
+    }
+};
@@ -1,19 +1,64 @@
 #pragma once
 #include "WebServer.h"
 #include "FileGetEndpoint.h"
+#include "BundleGetEndpoint.h"
+#include "PartitionMapDriver.h"
 
 class FileController {
 public:
     FileController(WebServer& server) 
-        : server(server) {}
+        : server(server)
+    {
+        // Rules first: both the index and the bundle evaluate them on load
+        cachePolicy.AddRule("/favicon.ico", "public, max-age=86400");
+    }
 
     void init()
     {
-        server.registerHandler("/*", HTTP_GET, getFile);
+        assets.Build();
+        streamer.Start(tskIDLE_PRIORITY + 5);  // above the assets server, so reads stay ahead
+        // The bundle, when flashed, holds the UI; FAT keeps uploaded files
+        HttpEndpoint& files = bundle.IsAttached() ? static_cast<HttpEndpoint&>(getBundle) : getFile;
+        server.registerHandler("/*", HTTP_GET, files, &downloads);
+        server.registerHandler("/*", HTTP_HEAD, files);
+    }
+
+    void UseAssetBundle(const PartitionMapDriver& partition)
+    {
+        if (partition.IsMapped())
+            bundle.Attach(partition.Data(), partition.Size());
+    }
+
+    /// Keeps the index in step with uploads and deletes (e.g. over FTP).
+    void OnFileChanged(const char* path)
+    {
+        assets.Refresh(path);
     }
 
+    const FileGetEndpoint::Streamer& GetStreamer() const { return streamer; }
+
 private:
     WebServer& server;
-    FileGetEndpoint getFile {"/fat"};
+    // Room for the followers as well as the readers: a request for a file
+    // already being read must start while that flight can still be joined,
+    // not queue behind it. Reads stay bounded by the streamer lanes (a
+    // request for another file waits there). The class stays below the
+    // server's socket count so HEADs, redirects and the other async classes
+    // always have a socket and a worker left.
+    WebServer::AsyncClass downloads {"downloads", downloadLimit(server)};
+    CachePolicy cachePolicy;
+    AssetIndex assets {"/fat", cachePolicy};
+    FileGetEndpoint::Streamer streamer;
+    FileGetEndpoint getFile {assets, streamer};
+    AssetBundle bundle {cachePolicy};
+    BundleGetEndpoint getBundle {bundle, getFile};
+
+    static uint8_t downloadLimit(const WebServer& server)
+    {
+        constexpr size_t wanted = FileGetEndpoint::MaxConcurrent + FileGetEndpoint::MaxFollowers;
+        size_t sockets = server.GetMaxOpenSockets();
+        size_t spare = sockets > FileGetEndpoint::MaxConcurrent ? sockets - 1 : FileGetEndpoint::MaxConcurrent;
+        return (uint8_t)(wanted < spare ? wanted : spare);
+    }
 
 };
@@ -0,0 +1,123 @@
+#pragma once
+#include "rom/miniz.h"
+#include "esp_log.h"
+#include "FunctionRef.h"
+#include <initializer_list>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// Turns a gzip member (RFC 1952) back into plain bytes as it streams past,
+/// using the tinfl inflater in ROM. Output leaves through `sink` in pieces
+/// of up to the 32 KB window, which is also the bulk of the ~43 KB taken
+/// from the heap for the lifetime of the inflater. The gzip header must
+/// arrive in the first Feed(); the trailer is not verified. `sink` is
+/// referenced, not copied, so it must outlive the inflater.
+class GzipInflater {
+    constexpr static const char* TAG = "GzipInflater";
+
+public:
+    using Sink = FunctionRef<bool(const char*, size_t)>;
+
+    explicit GzipInflater(Sink sink)
+        : sink(sink), state(new (std::nothrow) State) {
+        if (state)
+            tinfl_init(&state->decompressor);
+        else
+            ESP_LOGW(TAG, "No memory for the inflate window");
+    }
+
+    ~GzipInflater() { delete state; }
+
+    GzipInflater(const GzipInflater&) = delete;
+    GzipInflater& operator=(const GzipInflater&) = delete;
+
+    bool IsReady() const { return state != nullptr; }
+
+    /// Inflates the next piece of the compressed stream.
+    bool Feed(const char* data, size_t len) {
+        if (!state || failed)
+            return false;
+        const uint8_t* in = reinterpret_cast<const uint8_t*>(data);
+        if (!headerDone) {
+            size_t skip = headerLength(in, len);
+            if (skip == 0) {
+                ESP_LOGW(TAG, "Not a gzip stream");
+                return fail();
+            }
+            in += skip;
+            len -= skip;
+            headerDone = true;
+        }
+
+        while (!done) {
+            size_t inSize = len;
+            size_t outSize = TINFL_LZ_DICT_SIZE - dictOffset;
+            tinfl_status status = tinfl_decompress(&state->decompressor, in, &inSize, state->dict,
+                                                   state->dict + dictOffset, &outSize, TINFL_FLAG_HAS_MORE_INPUT);
+            in += inSize;
+            len -= inSize;
+            if (outSize > 0 && !sink(reinterpret_cast<const char*>(state->dict + dictOffset), outSize))
+                return fail();
+            dictOffset = (dictOffset + outSize) & (TINFL_LZ_DICT_SIZE - 1);
+
+            if (status < TINFL_STATUS_DONE) {
+                ESP_LOGW(TAG, "Corrupt deflate data (%d)", (int)status);
+                return fail();
+            }
+            if (status == TINFL_STATUS_DONE)
+                done = true;
+            else if (status == TINFL_STATUS_NEEDS_MORE_INPUT)
+                break;  // all of `in` consumed
+        }
+        return true;  // anything after the last block is the trailer
+    }
+
+    /// True once the whole deflate stream came out.
+    bool Finish() const { return done && !failed; }
+
+private:
+    struct State {
+        tinfl_decompressor decompressor;
+        uint8_t dict[TINFL_LZ_DICT_SIZE];
+    };
+
+    Sink sink;
+    State* state;
+    size_t dictOffset = 0;
+    bool headerDone = false;
+    bool done = false;
+    bool failed = false;
+
+    bool fail() {
+        failed = true;
+        return false;
+    }
+
+    /// Size of the member header, 0 when it is not gzip/deflate or does not
+    /// fit in `len` bytes.
+    static size_t headerLength(const uint8_t* p, size_t len) {
+        enum { FHCRC = 2, FEXTRA = 4, FNAME = 8, FCOMMENT = 16 };
+        if (len < 10 || p[0] != 0x1f || p[1] != 0x8b || p[2] != 8)
+            return 0;
+        uint8_t flags = p[3];
+        size_t pos = 10;
+        if (flags & FEXTRA) {
+            if (pos + 2 > len)
+                return 0;
+            pos += 2 + (p[pos] | p[pos + 1] << 8);
+        }
+        for (uint8_t field : {FNAME, FCOMMENT}) {
+            if (!(flags & field))
+                continue;
+            const void* end = pos < len ? memchr(p + pos, 0, len - pos) : nullptr;
+            if (!end)
+                return 0;
+            pos = static_cast<const uint8_t*>(end) - p + 1;
+        }
+        if (flags & FHCRC)
+            pos += 2;
+        return pos <= len ? pos : 0;
+    }
+};
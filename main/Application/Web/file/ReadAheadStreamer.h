@@ -0,0 +1,181 @@
+#pragma once
+#include "Queue.h"
+#include "Semaphore.h"
+#include "Task.h"
+#include "WideCounter.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+/// Streams byte ranges of open files with the next block read while the
+/// current one is being sent.
+/// Each stream borrows a lane (two BlockSize buffers) from a fixed pool; a
+/// single reader task fills them with sector-aligned pread()s, so flash and
+/// network overlap and nothing large sits on the caller's stack. A lane is
+/// held for the whole stream, sends included, so slow clients can hold all
+/// of them; a stream that finds none free does not wait but reads and sends
+/// in turn through a small buffer on its own stack, as before read-ahead.
+template <size_t Lanes, size_t BlockSize>
+class ReadAheadStreamer {
+    constexpr static const char* TAG = "ReadAhead";
+    constexpr static size_t DirectSize = 512;  // per-stream buffer without a lane
+
+public:
+    /// Throughput per file-size class, for comparing page loads. Bytes and
+    /// time are wide, so their ratio stays right however long the device runs.
+    struct SizeClass {
+        uint32_t maxSize;  // upper bound in bytes, UINT32_MAX for the last
+        std::atomic<uint32_t> streams{0};
+        WideCounter bytes;
+        WideCounter micros;  // time inside Stream()
+    };
+    constexpr static size_t SizeClassCount = 4;
+
+    ReadAheadStreamer()
+        : freeLanes(Lanes), jobs(Lanes) {
+        for (Lane& lane : lanes)
+            freeLanes.Push(&lane);
+    }
+
+    ReadAheadStreamer(const ReadAheadStreamer&) = delete;
+    ReadAheadStreamer& operator=(const ReadAheadStreamer&) = delete;
+
+    void Start(portBASE_TYPE priority, BaseType_t core = tskNO_AFFINITY) {
+        task.Init("ReadAhead", priority, 3072);
+        task.SetHandler([this]() { work(); });
+        task.Run(core);
+    }
+
+    /// Sends bytes [first, first + length) of `fd` through `sink`, a
+    /// `bool(const char*, size_t)`. Fails if the file ends early.
+    template <typename SINK>
+    esp_err_t Stream(int fd, uint32_t first, uint32_t length, SINK sink) {
+        int64_t start = esp_timer_get_time();
+        Lane* lane;
+        esp_err_t ret;
+        if (freeLanes.Pop(lane, 0)) {
+            ret = streamAhead(*lane, fd, first, length, sink);
+            freeLanes.Push(lane);
+        } else {
+            directStreams.fetch_add(1, std::memory_order_relaxed);
+            ret = streamDirect(fd, first, length, sink);
+        }
+
+        if (ret == ESP_OK)
+            record(length, esp_timer_get_time() - start);
+        return ret;
+    }
+
+    const SizeClass* GetSizeClasses() const { return sizeClasses; }
+
+    /// Streams that found every lane busy and read without read-ahead.
+    uint32_t GetDirectStreams() const { return directStreams.load(std::memory_order_relaxed); }
+
+private:
+    struct Lane {
+        char buffers[2][BlockSize];
+        Semaphore done;
+        ssize_t result = 0;
+    };
+
+    struct ReadJob {
+        Lane* lane;
+        int buffer;
+        int fd;
+        uint32_t offset;
+    };
+
+    Lane lanes[Lanes];
+    Queue<Lane*> freeLanes;
+    Queue<ReadJob> jobs;
+    Task task;
+    std::atomic<uint32_t> directStreams{0};
+    SizeClass sizeClasses[SizeClassCount] = {
+        {16 * 1024}, {64 * 1024}, {256 * 1024}, {UINT32_MAX}};
+
+    template <typename SINK>
+    esp_err_t streamAhead(Lane& lane, int fd, uint32_t first, uint32_t length, SINK& sink) {
+        const uint32_t end = first + length;
+        uint32_t pos = first - first % BlockSize;  // sector aligned
+        int cur = 0;
+        esp_err_t ret = ESP_OK;
+        bool pending = length > 0 && submit(lane, cur, fd, pos);
+        if (length > 0 && !pending)
+            ret = ESP_FAIL;
+
+        while (pending) {
+            lane.done.Take();
+            pending = false;
+            ssize_t n = lane.result;
+            if (n <= 0) {
+                ret = ESP_FAIL;
+                break;
+            }
+
+            uint32_t blockStart = pos;
+            pos += (uint32_t)n;
+            if (pos < end) {
+                if ((size_t)n < BlockSize || !submit(lane, cur ^ 1, fd, pos)) {
+                    ret = ESP_FAIL;  // file shorter than promised
+                    break;
+                }
+                pending = true;
+            }
+
+            uint32_t from = (first > blockStart ? first : blockStart) - blockStart;
+            uint32_t to = (end < pos ? end : pos) - blockStart;
+            if (to > from && !sink(lane.buffers[cur] + from, to - from)) {
+                ret = ESP_FAIL;
+                break;
+            }
+            cur ^= 1;
+        }
+        if (pending)
+            lane.done.Take();  // never hand back a lane with a read in flight
+        return ret;
+    }
+
+    /// Read, send, repeat, on the caller's task.
+    template <typename SINK>
+    esp_err_t streamDirect(int fd, uint32_t first, uint32_t length, SINK& sink) {
+        char buf[DirectSize];
+        for (uint32_t pos = first, end = first + length; pos < end;) {
+            size_t want = end - pos < DirectSize ? end - pos : DirectSize;
+            ssize_t n = pread(fd, buf, want, pos);
+            if (n <= 0 || !sink(buf, (size_t)n))
+                return ESP_FAIL;
+            pos += (uint32_t)n;
+        }
+        return ESP_OK;
+    }
+
+    bool submit(Lane& lane, int buffer, int fd, uint32_t offset) {
+        // One job per lane at most, so the queue never fills
+        return jobs.Push(ReadJob{&lane, buffer, fd, offset});
+    }
+
+    void work() {
+        ReadJob job;
+        while (true) {
+            if (!jobs.Pop(job, portMAX_DELAY))
+                continue;
+            job.lane->result = pread(job.fd, job.lane->buffers[job.buffer], BlockSize, job.offset);
+            job.lane->done.Give();
+        }
+    }
+
+    void record(uint32_t length, int64_t micros) {
+        for (SizeClass& c : sizeClasses) {
+            if (length <= c.maxSize) {
+                c.streams.fetch_add(1, std::memory_order_relaxed);
+                c.bytes.Add(length);
+                c.micros.Add((uint32_t)micros);
+                return;
+            }
+        }
+    }
+};
@@ -0,0 +1,234 @@
+#pragma once
+#include "Mutex.h"
+#include "ContextLock.h"
+#include "Semaphore.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "FunctionRef.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// Lets concurrent reads of the same byte range of the same file share one
+/// pass over flash, e.g. every screen reloading index.html after a reboot.
+/// The first caller (the leader) does the read and hands each block to its
+/// own sink and to every caller that joined before the first block went
+/// out; it waits until all of them are done with a block before the buffer
+/// can be reused, so the slowest client sets the pace. A follower that
+/// keeps a block longer than the ack timeout is dropped (its request fails)
+/// so one stalled client cannot hold the flight and its lane. Later callers
+/// start a flight of their own. Followers never open the file, so they take
+/// no FATFS handle and no read-ahead lane.
+template <size_t MaxFlights, size_t MaxFollowers>
+class SingleFlight {
+    constexpr static const char* TAG = "SingleFlight";
+
+public:
+    static constexpr size_t MaxKeyLength = 128;
+
+    using Sink = FunctionRef<bool(const char*, size_t)>;
+
+    /// Well above the time a live client needs to take one block.
+    static constexpr TickType_t DefaultAckTimeout = pdMS_TO_TICKS(3000);
+
+    explicit SingleFlight(TickType_t ackTimeout = DefaultAckTimeout)
+        : ackTimeout(ackTimeout) {}
+
+    /// Feeds bytes [first, first + length) of `key` to `sink`, either by
+    /// joining a flight that has not sent anything yet or by calling
+    /// `read(sink)` as the leader of a new one.
+    template <typename READ>
+    esp_err_t Run(const char* key, uint32_t first, uint32_t length, const Sink& sink, READ read) {
+        Flight* flight = nullptr;
+        Follower* follower = nullptr;
+        {
+            LOCK(mutex);
+            for (Flight& f : flights) {
+                if (f.active && !f.started && f.followerCount < MaxFollowers && f.first == first &&
+                    f.length == length && strcmp(f.key, key) == 0) {
+                    follower = &f.followers[f.followerCount++];
+                    follower->failed = false;
+                    follower->busy = false;
+                    follower->dropped = false;
+                    flight = &f;
+                    break;
+                }
+            }
+            for (size_t i = 0; i < MaxFlights && !flight; i++) {
+                if (!flights[i].active) {
+                    flight = &flights[i];
+                    flight->begin(key, first, length);
+                }
+            }
+        }
+
+        if (follower)
+            return follow(*flight, *follower, sink);
+        if (!flight)
+            return read(sink);  // every flight in use: read alone
+        return lead(*flight, sink, read);
+    }
+
+private:
+    struct Follower {
+        Semaphore ready;  // a block or the end was published
+        bool failed = false;
+        bool busy = false;     // holds the current publication
+        bool dropped = false;  // missed the ack timeout; the flight went on
+    };
+
+    struct Flight {
+        char key[MaxKeyLength];
+        uint32_t first = 0;
+        uint32_t length = 0;
+        bool active = false;
+        bool started = false;  // first block published; no more joins
+        bool finished = false;
+        esp_err_t result = ESP_OK;
+
+        const char* data = nullptr;
+        size_t len = 0;
+        size_t outstanding = 0;  // followers still busy with the current publication
+        Semaphore acked;         // given by the last of them
+        size_t draining = 0;     // dropped followers still in their sink
+        bool leaderDone = false; // the last of those frees the flight
+
+        Follower followers[MaxFollowers];
+        size_t followerCount = 0;
+
+        void begin(const char* k, uint32_t f, uint32_t l) {
+            strncpy(key, k, sizeof(key));
+            key[sizeof(key) - 1] = '\0';
+            first = f;
+            length = l;
+            active = true;
+            started = false;
+            finished = false;
+            followerCount = 0;
+            draining = 0;
+            leaderDone = false;
+        }
+    };
+
+    const TickType_t ackTimeout;
+    Mutex mutex;
+    Flight flights[MaxFlights];
+
+    template <typename READ>
+    esp_err_t lead(Flight& flight, const Sink& sink, READ read) {
+        bool ownOk = true;
+        esp_err_t ret = read([&](const char* data, size_t len) {
+            size_t waiting = publish(flight, data, len, false, ESP_OK);
+            if (ownOk)
+                ownOk = sink(data, len);
+            if (waiting)
+                awaitAcks(flight);
+            // Keep reading for the others even if our own client is gone
+            return ownOk || liveFollowers(flight) > 0;
+        });
+
+        if (publish(flight, nullptr, 0, true, ret))
+            awaitAcks(flight);
+        {
+            LOCK(mutex);
+            if (flight.followerCount)
+                ESP_LOGI(TAG, "%s read once for %u clients", flight.key, (unsigned)flight.followerCount + 1);
+            // Dropped followers still hold `flight`; the last one frees it
+            if (flight.draining)
+                flight.leaderDone = true;
+            else
+                flight.active = false;
+        }
+        return ownOk ? ret : ESP_FAIL;
+    }
+
+    /// Hands a block (or the end) to the live followers; returns how many
+    /// will acknowledge it.
+    size_t publish(Flight& flight, const char* data, size_t len, bool finished, esp_err_t result) {
+        LOCK(mutex);
+        flight.started = true;
+        flight.data = data;
+        flight.len = len;
+        flight.finished = finished;
+        flight.result = result;
+        flight.outstanding = 0;
+        for (size_t i = 0; i < flight.followerCount; i++) {
+            if (!flight.followers[i].failed) {
+                flight.outstanding++;
+                flight.followers[i].busy = true;
+                flight.followers[i].ready.Give();
+            }
+        }
+        return flight.outstanding;
+    }
+
+    /// Waits for the followers to finish with the current publication and
+    /// drops the ones that do not make it in time. A dropped follower may
+    /// still be sending from the buffer the leader goes on to reuse; its
+    /// request fails and its connection closes, so the client never takes
+    /// that body as complete.
+    void awaitAcks(Flight& flight) {
+        if (flight.acked.Take(ackTimeout))
+            return;
+        LOCK(mutex);
+        if (flight.outstanding == 0) {
+            flight.acked.Take(0);  // the last ack came in as we gave up
+            return;
+        }
+        for (size_t i = 0; i < flight.followerCount; i++) {
+            Follower& f = flight.followers[i];
+            if (f.busy) {
+                f.busy = false;
+                f.failed = true;
+                f.dropped = true;
+                flight.draining++;
+            }
+        }
+        ESP_LOGW(TAG, "%s dropped %u stalled clients", flight.key, (unsigned)flight.outstanding);
+        flight.outstanding = 0;
+    }
+
+    size_t liveFollowers(Flight& flight) {
+        LOCK(mutex);
+        size_t live = 0;
+        for (size_t i = 0; i < flight.followerCount; i++)
+            live += flight.followers[i].failed ? 0 : 1;
+        return live;
+    }
+
+    esp_err_t follow(Flight& flight, Follower& self, const Sink& sink) {
+        while (true) {
+            self.ready.Take();
+            const char* data;
+            size_t len;
+            bool finished;
+            esp_err_t result;
+            {
+                LOCK(mutex);
+                data = flight.data;
+                len = flight.len;
+                finished = flight.finished;
+                result = flight.result;
+            }
+
+            bool ok = finished || sink(data, len);
+            {
+                LOCK(mutex);
+                if (self.dropped) {
+                    if (--flight.draining == 0 && flight.leaderDone)
+                        flight.active = false;
+                    return ESP_FAIL;
+                }
+                self.busy = false;
+                if (!ok)
+                    self.failed = true;
+                if (--flight.outstanding == 0)
+                    flight.acked.Give();
+            }
+            if (finished)
+                return result;
+            if (!ok)
+                return ESP_FAIL;
+        }
+    }
+};
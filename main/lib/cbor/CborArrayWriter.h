@@ -0,0 +1,27 @@
+#pragma once
+#include "CborContext.h"
+
+class CborArrayWriter : public CborContext {
+    friend class CborContext;
+    explicit CborArrayWriter(Stream& s) : CborContext(s) { writeBeginArray(); }
+    ~CborArrayWriter() { writeEndArray(); }
+
+public:
+    void value(int64_t v) { writer.writeInt(v); }
+    void value(uint64_t v) { writer.writeUInt(v); }
+    void value(const char* v) { writer.writeString(v); }
+    void value(bool v) { writer.writeBool(v); }
+    void fieldData(const uint8_t* data, size_t len) { writer.writeData(data, len); }
+    void valueNull() { writeNull(); }
+
+    template<typename FUNC>
+    void withObject(FUNC callback);
+
+    template<typename FUNC>
+    void withArray(FUNC callback);
+
+    template <typename FUNC>
+    static void create(Stream& stream, FUNC callback);
+};
+
+#include "CborWriters.inl"
@@ -0,0 +1,23 @@
+#pragma once
+#include "IStreamWriter.h"
+#include "CborStreamWriter.h"
+
+class CborObjectWriter;
+class CborArrayWriter;
+
+/// Maps and arrays are written with indefinite length, so like the JSON
+/// writers nothing needs to know the member count up front.
+class CborContext {
+protected:
+    Stream& stream;
+    CborStreamWriter writer;
+
+    explicit CborContext(Stream& s)
+        : stream(s), writer(s) {}
+
+    void writeBeginObject() { writer.writeBeginIndefinite(CborStreamWriter::Map); }
+    void writeEndObject()   { writer.writeBreak(); }
+    void writeBeginArray()  { writer.writeBeginIndefinite(CborStreamWriter::Array); }
+    void writeEndArray()    { writer.writeBreak(); }
+    void writeNull()        { writer.writeNull(); }
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include "CborContext.h"
+
+class CborObjectWriter : public CborContext {
+    friend class CborContext;
+    explicit CborObjectWriter(Stream& s) : CborContext(s) { writeBeginObject(); }
+    ~CborObjectWriter() { writeEndObject(); }
+
+public:
+    void field(const char* key, int64_t v) {
+        writer.writeString(key); writer.writeInt(v);
+    }
+    void field(const char* key, uint64_t v) {
+        writer.writeString(key); writer.writeUInt(v);
+    }
+    void field(const char* key, const char* v) {
+        writer.writeString(key); writer.writeString(v);
+    }
+    void field(const char* key, bool v) {
+        writer.writeString(key); writer.writeBool(v);
+    }
+    void fieldData(const char* key, const uint8_t* data, size_t len) {
+        writer.writeString(key); writer.writeData(data, len);
+    }
+    void fieldNull(const char* key) {
+        writer.writeString(key); writeNull();
+    }
+
+
+    template <typename FUNC>
+    void withObject(const char* key, FUNC callback);
+
+    template <typename FUNC>
+    void withArray(const char* key, FUNC callback);
+
+    template <typename FUNC>
+    static void create(Stream& stream, FUNC callback);
+};
+
+#include "CborWriters.inl"
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include "Stream.h"
+#include "IStreamWriter.h"
+
+/// CBOR (RFC 8949) encoder behind the same interface as JsonStreamWriter.
+/// Values are emitted in their shortest form; binary data goes out as a raw
+/// byte string instead of base64.
+class CborStreamWriter : public IStreamWriter
+{
+    Stream &out;
+
+public:
+    enum MajorType : uint8_t
+    {
+        UnsignedInt = 0,
+        NegativeInt = 1,
+        ByteString = 2,
+        TextString = 3,
+        Array = 4,
+        Map = 5,
+        Simple = 7,
+    };
+
+    static constexpr uint8_t False = 0xF4;
+    static constexpr uint8_t True = 0xF5;
+    static constexpr uint8_t Null = 0xF6;
+    static constexpr uint8_t Float32 = 0xFA;
+    static constexpr uint8_t Float64 = 0xFB;
+    static constexpr uint8_t Indefinite = 31;
+    static constexpr uint8_t Break = 0xFF;
+
+    explicit CborStreamWriter(Stream &s) : out(s) {}
+
+    void writeBool(bool v) override
+    {
+        writeByte(v ? True : False);
+    }
+
+    void writeInt(int64_t v) override
+    {
+        if (v >= 0)
+            writeHead(UnsignedInt, static_cast<uint64_t>(v));
+        else
+            writeHead(NegativeInt, static_cast<uint64_t>(-1 - v));
+    }
+
+    void writeUInt(uint64_t v) override
+    {
+        writeHead(UnsignedInt, v);
+    }
+
+    void writeFloat(float v) override
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        writeByte(Float32);
+        writeBigEndian(bits, 4);
+    }
+
+    void writeDouble(double v) override
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        writeByte(Float64);
+        writeBigEndian(bits, 8);
+    }
+
+    void writeString(const char *v) override
+    {
+        size_t len = std::strlen(v);
+        writeHead(TextString, len);
+        out.write(v, len);
+    }
+
+    void writeData(const void *data, size_t len) override
+    {
+        writeHead(ByteString, len);
+        out.write(data, len);
+    }
+
+    void writeNull()
+    {
+        writeByte(Null);
+    }
+
+    /// Start of an indefinite-length map or array, closed by writeBreak().
+    void writeBeginIndefinite(MajorType type)
+    {
+        writeByte(static_cast<uint8_t>((type << 5) | Indefinite));
+    }
+
+    void writeBreak()
+    {
+        writeByte(Break);
+    }
+
+private:
+    void writeByte(uint8_t b)
+    {
+        out.write(&b, 1);
+    }
+
+    void writeBigEndian(uint64_t v, size_t bytes)
+    {
+        uint8_t buf[8];
+        for (size_t i = 0; i < bytes; i++)
+            buf[i] = static_cast<uint8_t>(v >> (8 * (bytes - 1 - i)));
+        out.write(buf, bytes);
+    }
+
+    void writeHead(MajorType type, uint64_t value)
+    {
+        uint8_t major = static_cast<uint8_t>(type << 5);
+        if (value < 24)
+        {
+            writeByte(major | static_cast<uint8_t>(value));
+        }
+        else if (value <= 0xFF)
+        {
+            writeByte(major | 24);
+            writeBigEndian(value, 1);
+        }
+        else if (value <= 0xFFFF)
+        {
+            writeByte(major | 25);
+            writeBigEndian(value, 2);
+        }
+        else if (value <= 0xFFFFFFFF)
+        {
+            writeByte(major | 26);
+            writeBigEndian(value, 4);
+        }
+        else
+        {
+            writeByte(major | 27);
+            writeBigEndian(value, 8);
+        }
+    }
+};
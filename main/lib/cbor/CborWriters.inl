@@ -0,0 +1,39 @@
+#pragma once
+#include "CborObjectWriter.h"
+#include "CborArrayWriter.h"
+
+// CborObjectWriter impls
+template<typename FUNC>
+void CborObjectWriter::withObject(const char* key, FUNC callback) {
+    writer.writeString(key);
+    CborObjectWriter::create(stream, callback);
+}
+
+template<typename FUNC>
+void CborObjectWriter::withArray(const char* key, FUNC callback) {
+    writer.writeString(key);
+    CborArrayWriter::create(stream, callback);
+}
+
+template<typename FUNC>
+void CborObjectWriter::create(Stream& stream, FUNC callback) {
+    CborObjectWriter root(stream);
+    callback(root);
+}
+
+// CborArrayWriter impls
+template<typename FUNC>
+void CborArrayWriter::withObject(FUNC callback) {
+    CborObjectWriter::create(stream, callback);
+}
+
+template<typename FUNC>
+void CborArrayWriter::withArray(FUNC callback) {
+    CborArrayWriter::create(stream, callback);
+}
+
+template<typename FUNC>
+void CborArrayWriter::create(Stream& stream, FUNC callback) {
+    CborArrayWriter root(stream);
+    callback(root);
+}
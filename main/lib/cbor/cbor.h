@@ -0,0 +1,7 @@
+#pragma once
+
+#include "CborArrayWriter.h"
+#include "CborContext.h"
+#include "CborObjectWriter.h"
+#include "CborStreamWriter.h"
+
@@ -0,0 +1,32 @@
+#pragma once
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature>
+class FunctionRef;
+
+/// Non-owning reference to a callable, for callbacks that only run while
+/// the call that received them is on the stack. Two pointers, never
+/// allocates, unlike std::function with a capture list larger than its
+/// small buffer. The callable must outlive the reference: bind a named
+/// lambda, or pass a temporary straight into the call.
+template <typename R, typename... Args>
+class FunctionRef<R(Args...)>
+{
+public:
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, FunctionRef>>>
+    FunctionRef(F &&f)
+        : object(const_cast<void *>(static_cast<const void *>(std::addressof(f)))),
+          call([](void *o, Args... args) -> R {
+              return (*static_cast<std::remove_reference_t<F> *>(o))(std::forward<Args>(args)...);
+          })
+    {
+    }
+
+    R operator()(Args... args) const { return call(object, std::forward<Args>(args)...); }
+
+private:
+    void *object;
+    R (*call)(void *, Args...);
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+
+/// 64-bit counter made of two 32-bit atomics, for targets without lock-free
+/// 64-bit atomics such as the ESP32. Add() is lock-free: it adds to the low
+/// word and bumps the high word when that add wraps. A reader that lands
+/// between a wrap and its carry sees the total 2^32 short once; the next
+/// Load() is right again.
+class WideCounter
+{
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "counters must not take a lock");
+
+public:
+    void Add(uint32_t n)
+    {
+        uint32_t before = low.fetch_add(n, std::memory_order_relaxed);
+        if (before + n < before)
+            high.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t Load() const
+    {
+        uint32_t h, l;
+        do
+        {
+            h = high.load(std::memory_order_acquire);
+            l = low.load(std::memory_order_acquire);
+        } while (h != high.load(std::memory_order_acquire));
+        return (uint64_t)h << 32 | l;
+    }
+
+private:
+    std::atomic<uint32_t> low{0};
+    std::atomic<uint32_t> high{0};
+};
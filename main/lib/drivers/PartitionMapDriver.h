@@ -0,0 +1,92 @@
+#pragma once
+#include "esp_partition.h"
+#include "esp_log.h"
+#include <stdint.h>
+#include <stdio.h>
+#if CONFIG_IDF_TARGET_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// Maps a whole data partition read-only into the address space.
+/// On the Linux target there is no flash MMU: `<label>.bin` in the working
+/// directory (e.g. the packer's output) is mapped with mmap instead, so the
+/// same code runs on the host.
+class PartitionMapDriver {
+    constexpr static const char* TAG = "PartitionMapDriver";
+
+public:
+    PartitionMapDriver(const char* partitionLabel)
+        : partitionLabel(partitionLabel) {}
+
+    esp_err_t Init()
+    {
+#if CONFIG_IDF_TARGET_LINUX
+        char path[64];
+        snprintf(path, sizeof(path), "%s.bin", partitionLabel);
+        int fd = open(path, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+            if (fd >= 0)
+                close(fd);
+            ESP_LOGW(TAG, "No image file %s", path);
+            return ESP_ERR_NOT_FOUND;
+        }
+        void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (ptr == MAP_FAILED) {
+            ESP_LOGE(TAG, "Failed to map %s", path);
+            return ESP_FAIL;
+        }
+        data = static_cast<const uint8_t*>(ptr);
+        size = st.st_size;
+#else
+        const esp_partition_t* partition = esp_partition_find_first(
+            ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partitionLabel);
+        if (!partition) {
+            ESP_LOGW(TAG, "No partition '%s'", partitionLabel);
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        const void* ptr;
+        esp_err_t err = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &ptr, &handle);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to map '%s' (%s)", partitionLabel, esp_err_to_name(err));
+            return err;
+        }
+        data = static_cast<const uint8_t*>(ptr);
+        size = partition->size;
+#endif
+        ESP_LOGI(TAG, "Mapped '%s' (%u bytes)", partitionLabel, (unsigned)size);
+        return ESP_OK;
+    }
+
+    void Unmap()
+    {
+        if (!data)
+            return;
+#if CONFIG_IDF_TARGET_LINUX
+        munmap(const_cast<uint8_t*>(data), size);
+#else
+        esp_partition_munmap(handle);
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    const uint8_t* Data() const { return data; }
+    size_t Size() const { return size; }
+    bool IsMapped() const { return data != nullptr; }
+
+    ~PartitionMapDriver() { Unmap(); }
+
+private:
+    const char* partitionLabel;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#if !CONFIG_IDF_TARGET_LINUX
+    esp_partition_mmap_handle_t handle = 0;
+#endif
+};
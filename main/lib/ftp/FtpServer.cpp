@@ -393,6 +393,7 @@ void FtpServer::ftp_cmd_stor(Client &c, const char *args) {
     }
     close(fd);
     closeDataConnection(c);
+    notifyChange(fullpath);
 
     const char *done = "226 Transfer complete\r\n";
     send(c.client_sock, done, strlen(done), 0);
@@ -410,6 +411,7 @@ void FtpServer::ftp_cmd_dele(Client &c, const char *args) {
              c.cwd[0] ? c.cwd : "", args);
 
     if (unlink(fullpath) == 0) {
+        notifyChange(fullpath);
         char resp[256];
         snprintf(resp, sizeof(resp), "250 File deleted: %s\r\n", args);
         send(c.client_sock, resp, strlen(resp), 0);
@@ -431,6 +433,7 @@ void FtpServer::ftp_cmd_rmd(Client &c, const char *args) {
              c.cwd[0] ? c.cwd : "", args);
 
     if (rmdir(fullpath) == 0) {
+        notifyChange(fullpath);
         char resp[256];
         snprintf(resp, sizeof(resp), "250 Directory removed: %s\r\n", args);
         send(c.client_sock, resp, strlen(resp), 0);
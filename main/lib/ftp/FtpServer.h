@@ -1,5 +1,5 @@
 #pragma once
-
+#include <functional>
 
 #define FTP_CTRL_PORT 21
 #define FTP_BUFFER_SIZE 512
@@ -22,6 +22,10 @@ public:
     bool init();
     void tick();
 
+    /// Called with the full path after a file is stored or deleted, or a
+    /// directory removed. Runs on the task calling tick().
+    void setChangeHandler(std::function<void(const char* path)> handler) { onChange = handler; }
+
 private:
     // === Helpers ===
     int  openDataConnection(Client& c);
@@ -61,4 +65,9 @@ private:
     int listen_sock;
     char root_path[128];
     Client clients[FTP_MAX_CLIENTS];
+    std::function<void(const char* path)> onChange;
+
+    void notifyChange(const char* path) {
+        if (onChange) onChange(path);
+    }
 };
@@ -0,0 +1,478 @@
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include "Stream.h"
+
+/// Pull-style JSON reader, the counterpart of JsonStreamWriter.
+/// Reads from any Stream through a small fixed buffer and never allocates,
+/// so bodies of any size parse in bounded memory. The caller walks the
+/// document and binds values straight into its own fields:
+///
+///   json.readObject([&](const char* key) {
+///       if (strcmp(key, "score") == 0) json.readInt(score);
+///       else if (strcmp(key, "mac") == 0) json.readString(mac, sizeof(mac));
+///   });
+///
+/// Values the callback does not read are skipped. Errors are sticky: after
+/// the first one every read returns false and failed() reports it.
+class JsonStreamReader
+{
+public:
+    static constexpr size_t MaxKeyLength = 32;
+    static constexpr size_t MaxDepth = 16;
+
+    enum class Type
+    {
+        Object,
+        Array,
+        String,
+        Number,
+        Bool,
+        Null,
+        Invalid,
+    };
+
+    explicit JsonStreamReader(Stream &s) : in(s) {}
+
+    bool failed() const { return error; }
+    void fail() { error = true; }
+
+    /// Type of the next value, without consuming it.
+    Type peekType()
+    {
+        switch (peekNonWs())
+        {
+        case '{': return Type::Object;
+        case '[': return Type::Array;
+        case '"': return Type::String;
+        case 't': case 'f': return Type::Bool;
+        case 'n': return Type::Null;
+        case '-': case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            return Type::Number;
+        default: return Type::Invalid;
+        }
+    }
+
+    /// Calls callback(key) for every member; the callback reads the value.
+    template <typename FUNC>
+    bool readObject(FUNC callback)
+    {
+        if (!enter('{'))
+            return false;
+        if (peekNonWs() == '}')
+        {
+            nextNonWs();
+            return leave();
+        }
+
+        while (!error)
+        {
+            char key[MaxKeyLength];
+            if (!readString(key, sizeof(key)) || !expect(':'))
+                break;
+            if (!readMember(callback, key))
+                break;
+
+            int c = nextNonWs();
+            if (c == '}')
+                return leave();
+            if (c != ',')
+                error = true;
+        }
+        return false;
+    }
+
+    /// Calls callback(index) for every element; the callback reads the value.
+    template <typename FUNC>
+    bool readArray(FUNC callback)
+    {
+        if (!enter('['))
+            return false;
+        if (peekNonWs() == ']')
+        {
+            nextNonWs();
+            return leave();
+        }
+
+        for (size_t index = 0; !error; index++)
+        {
+            if (!readMember(callback, index))
+                break;
+
+            int c = nextNonWs();
+            if (c == ']')
+                return leave();
+            if (c != ',')
+                error = true;
+        }
+        return false;
+    }
+
+    /// Reads a string into `out`; fails if it does not fit (with the terminator).
+    bool readString(char *out, size_t outSize)
+    {
+        bool fits = true;
+        return readStringText(out, outSize, fits) && (fits || fault());
+    }
+
+    bool readInt(int64_t &v)
+    {
+        bool fits = true;
+        return readIntText(v, fits) && (fits || fault());
+    }
+
+    bool readInt(int32_t &v)
+    {
+        bool fits = true;
+        return readIntText(v, fits) && (fits || fault());
+    }
+
+    /// Like readString, but a string that does not fit is consumed whole and
+    /// only this read fails; the reader stays usable. `out` is empty then.
+    bool readStringIfFits(char *out, size_t outSize)
+    {
+        bool fits = true;
+        return readStringText(out, outSize, fits) && fits;
+    }
+
+    /// Like readInt, but a number that is not an int32 (too big, fraction,
+    /// exponent) is consumed and only this read fails; the reader stays usable.
+    bool readIntIfFits(int32_t &v)
+    {
+        bool fits = true;
+        return readIntText(v, fits) && fits;
+    }
+
+    bool readDouble(double &v)
+    {
+        char buf[32];
+        if (!readNumberText(buf, sizeof(buf)))
+            return false;
+        char *end = nullptr;
+        v = strtod(buf, &end);
+        if (*end != '\0')
+            return fault();
+        return true;
+    }
+
+    bool readBool(bool &v)
+    {
+        v = peekNonWs() == 't';
+        return literal(v ? "true" : "false");
+    }
+
+    bool readNull() { return literal("null"); }
+
+    /// Consumes the next value of any type.
+    bool skip()
+    {
+        switch (peekType())
+        {
+        case Type::Object: return readObject([](const char *) {});
+        case Type::Array: return readArray([](size_t) {});
+        case Type::String: return skipString();
+        case Type::Number: { double d; return readDouble(d); }
+        case Type::Bool: { bool b; return readBool(b); }
+        case Type::Null: return readNull();
+        default: return fault();
+        }
+    }
+
+    /// True when the document parsed cleanly and only whitespace follows.
+    bool finish()
+    {
+        return !error && values > 0 && depth == 0 && peekNonWs() == End;
+    }
+
+private:
+    static constexpr int End = -1;
+    static constexpr size_t BufferSize = 64;
+
+    Stream &in;
+    char buffer[BufferSize];
+    size_t pos = 0;
+    size_t len = 0;
+    size_t depth = 0;
+    uint32_t values = 0; // completed values, used to detect unread members
+    bool error = false;
+
+    int peek()
+    {
+        if (pos == len)
+        {
+            pos = 0;
+            len = in.read(buffer, sizeof(buffer));
+            if (len == 0)
+                return End;
+        }
+        return (unsigned char)buffer[pos];
+    }
+
+    int next()
+    {
+        int c = peek();
+        if (c != End)
+            pos++;
+        return c;
+    }
+
+    int peekNonWs()
+    {
+        int c = peek();
+        while (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+        {
+            pos++;
+            c = peek();
+        }
+        return c;
+    }
+
+    int nextNonWs()
+    {
+        int c = peekNonWs();
+        if (c != End)
+            pos++;
+        return c;
+    }
+
+    bool expect(char c)
+    {
+        if (error || nextNonWs() != c)
+            return fault();
+        return true;
+    }
+
+    bool fault()
+    {
+        error = true;
+        return false;
+    }
+
+    bool enter(char open)
+    {
+        if (depth == MaxDepth || !expect(open))
+            return fault();
+        depth++;
+        return true;
+    }
+
+    bool leave()
+    {
+        depth--;
+        values++;
+        return true;
+    }
+
+    template <typename FUNC, typename ARG>
+    bool readMember(FUNC &callback, ARG arg)
+    {
+        uint32_t before = values;
+        callback(arg);
+        if (!error && values == before)
+            skip();
+        return !error;
+    }
+
+    bool literal(const char *word)
+    {
+        if (error)
+            return false;
+        peekNonWs();
+        for (const char *p = word; *p; p++)
+        {
+            if (next() != *p)
+                return fault();
+        }
+        values++;
+        return true;
+    }
+
+    bool readNumberText(char *out, size_t outSize)
+    {
+        bool fits = true;
+        return readNumberText(out, outSize, fits) && (fits || fault());
+    }
+
+    /// Consumes a number; `fits` turns false (and `out` is cut short) when
+    /// its text is longer than `out`.
+    bool readNumberText(char *out, size_t outSize, bool &fits)
+    {
+        if (error || peekType() != Type::Number)
+            return fault();
+        size_t n = 0;
+        for (int c = peek(); (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E'; c = peek())
+        {
+            next();
+            if (n + 1 == outSize)
+                fits = false;
+            else
+                out[n++] = (char)c;
+        }
+        out[n] = '\0';
+        values++;
+        return true;
+    }
+
+    /// Consumes a string; `fits` turns false (and `out` is empty) when it
+    /// does not fit with the terminator. Malformed strings fail the reader.
+    bool readStringText(char *out, size_t outSize, bool &fits)
+    {
+        if (!expect('"'))
+            return false;
+
+        size_t n = 0;
+        while (!error)
+        {
+            int c = next();
+            if (c == '"')
+            {
+                out[fits ? n : 0] = '\0';
+                values++;
+                return true;
+            }
+            if (c < 0x20)
+                break; // end of input or raw control character
+
+            char utf8[4];
+            size_t len = 1;
+            utf8[0] = (char)c;
+            if (c == '\\' && !unescape(utf8, len))
+                break;
+            if (n + len >= outSize)
+                fits = false;
+            if (fits)
+            {
+                memcpy(out + n, utf8, len);
+                n += len;
+            }
+        }
+        out[0] = '\0';
+        return fault();
+    }
+
+    /// Consumes a number; `fits` turns false when it is not an integer
+    /// within T's range. Only malformed input fails the reader.
+    template <typename T>
+    bool readIntText(T &v, bool &fits)
+    {
+        char buf[24];
+        if (!readNumberText(buf, sizeof(buf), fits))
+            return false;
+        if (!fits || strpbrk(buf, ".eE"))
+        {
+            fits = false;
+            return true;
+        }
+        char *end = nullptr;
+        errno = 0;
+        long long parsed = strtoll(buf, &end, 10);
+        // strtoll clamps out-of-range input to LLONG_MIN/MAX and sets ERANGE
+        static_assert(sizeof(long long) == sizeof(int64_t), "strtoll must cover int64_t exactly");
+        if (*end != '\0')
+            return fault(); // not a number at all, e.g. "1-2"
+        if (errno == ERANGE || parsed < std::numeric_limits<T>::min() || parsed > std::numeric_limits<T>::max())
+        {
+            fits = false;
+            return true;
+        }
+        v = (T)parsed;
+        return true;
+    }
+
+    bool skipString()
+    {
+        if (!expect('"'))
+            return false;
+        while (true)
+        {
+            int c = next();
+            if (c == '"')
+                break;
+            if (c < 0x20)
+                return fault();
+            if (c == '\\' && next() == End)
+                return fault();
+        }
+        values++;
+        return true;
+    }
+
+    int readHex4()
+    {
+        int v = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            int c = next();
+            int d = (c >= '0' && c <= '9') ? c - '0'
+                  : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                  : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+                  : -1;
+            if (d < 0)
+                return -1;
+            v = (v << 4) | d;
+        }
+        return v;
+    }
+
+    /// Decodes the escape after a backslash into UTF-8.
+    bool unescape(char *out, size_t &outLen)
+    {
+        int c = next();
+        outLen = 1;
+        switch (c)
+        {
+        case '"': case '\\': case '/': out[0] = (char)c; return true;
+        case 'b': out[0] = '\b'; return true;
+        case 'f': out[0] = '\f'; return true;
+        case 'n': out[0] = '\n'; return true;
+        case 'r': out[0] = '\r'; return true;
+        case 't': out[0] = '\t'; return true;
+        case 'u': break;
+        default: return false;
+        }
+
+        int cp = readHex4();
+        if (cp < 0)
+            return false;
+        if (cp >= 0xD800 && cp <= 0xDBFF)
+        {
+            if (next() != '\\' || next() != 'u')
+                return false;
+            int low = readHex4();
+            if (low < 0xDC00 || low > 0xDFFF)
+                return false;
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        }
+
+        if (cp < 0x80)
+        {
+            out[0] = (char)cp;
+        }
+        else if (cp < 0x800)
+        {
+            out[0] = (char)(0xC0 | (cp >> 6));
+            out[1] = (char)(0x80 | (cp & 0x3F));
+            outLen = 2;
+        }
+        else if (cp < 0x10000)
+        {
+            out[0] = (char)(0xE0 | (cp >> 12));
+            out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+            out[2] = (char)(0x80 | (cp & 0x3F));
+            outLen = 3;
+        }
+        else
+        {
+            out[0] = (char)(0xF0 | (cp >> 18));
+            out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+            out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+            out[3] = (char)(0x80 | (cp & 0x3F));
+            outLen = 4;
+        }
+        return true;
+    }
+};
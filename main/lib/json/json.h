@@ -4,5 +4,6 @@
 #include "JsonContext.h"
 #include "JsonEscapedStream.h"
 #include "JsonObjectWriter.h"
+#include "JsonStreamReader.h"
 #include "JsonStreamWriter.h"
 
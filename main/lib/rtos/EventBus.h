@@ -0,0 +1,183 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+#include "Semaphore.h"
+
+/// Single-producer, multi-subscriber ring in the style of a disruptor.
+/// The producer writes every item once into a shared slot; each subscriber
+/// walks the ring with its own cursor and reads slots in place, so adding
+/// subscribers adds no copies. The producer never waits: a subscriber that
+/// falls more than Capacity items behind skips ahead and counts the loss.
+template <typename T, size_t Capacity, size_t MaxSubscribers>
+class EventBus
+{
+	static constexpr uint32_t Invalid = UINT32_MAX;
+
+public:
+	class Subscriber
+	{
+		friend class EventBus;
+
+	public:
+		struct Stats
+		{
+			uint32_t received;
+			uint32_t dropped;
+			uint32_t lag;
+		};
+
+		/// Wait up to `timeout` for the next item and pass it to `fn` in place.
+		/// Returns false on timeout or when the item was lost to an overrun.
+		template <typename FUNC>
+		bool Read(FUNC&& fn, TickType_t timeout)
+		{
+			return bus->read(*this, fn, timeout);
+		}
+
+		Stats GetStats() const
+		{
+			return Stats{
+				received.load(std::memory_order_relaxed),
+				dropped.load(std::memory_order_relaxed),
+				bus->head.load(std::memory_order_relaxed) - cursor.load(std::memory_order_relaxed)};
+		}
+
+		const char* GetName() const { return name; }
+
+	private:
+		EventBus* bus = nullptr;
+		const char* name = nullptr;
+		std::atomic<bool> used{false};
+		std::atomic<uint32_t> cursor{0};
+		std::atomic<uint32_t> reading{Invalid}; // sequence pinned while a callback runs
+		std::atomic<uint32_t> received{0};
+		std::atomic<uint32_t> dropped{0};
+		Semaphore wake;
+	};
+
+	EventBus() = default;
+	EventBus(const EventBus&) = delete;
+	EventBus& operator=(const EventBus&) = delete;
+
+	/// Register a subscriber; it sees items published from now on.
+	Subscriber* Subscribe(const char* name)
+	{
+		for (auto& s : subscribers)
+		{
+			bool expected = false;
+			if (s.used.compare_exchange_strong(expected, true))
+			{
+				s.bus = this;
+				s.name = name;
+				s.received = 0;
+				s.dropped = 0;
+				s.cursor = head.load(std::memory_order_acquire);
+				return &s;
+			}
+		}
+		return nullptr;
+	}
+
+	void Unsubscribe(Subscriber* s)
+	{
+		if (s)
+			s->used = false;
+	}
+
+	/// Fill the next slot in place and wake the subscribers. Fails only when
+	/// a subscriber is still reading the slot that would be overwritten.
+	template <typename FUNC>
+	bool Publish(FUNC&& fill)
+	{
+		uint32_t seq = head.load(std::memory_order_relaxed);
+		Slot& slot = slots[seq % Capacity];
+
+		uint32_t old = slot.seq.load(std::memory_order_relaxed);
+		slot.seq.store(Invalid);
+		if (old != Invalid)
+		{
+			for (auto& s : subscribers)
+			{
+				if (s.used.load(std::memory_order_relaxed) && s.reading.load() == old)
+				{
+					slot.seq.store(old, std::memory_order_release);
+					publishDrops.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+			}
+		}
+
+		fill(slot.value);
+		slot.seq.store(seq, std::memory_order_release);
+		head.store(seq + 1, std::memory_order_release);
+
+		for (auto& s : subscribers)
+		{
+			if (s.used.load(std::memory_order_relaxed))
+				s.wake.Give();
+		}
+		return true;
+	}
+
+	template <typename FUNC>
+	void ForEachSubscriber(FUNC&& fn) const
+	{
+		for (const auto& s : subscribers)
+		{
+			if (s.used.load(std::memory_order_relaxed))
+				fn(s);
+		}
+	}
+
+	uint32_t GetPublished() const { return head.load(std::memory_order_relaxed); }
+	uint32_t GetPublishDrops() const { return publishDrops.load(std::memory_order_relaxed); }
+
+private:
+	struct Slot
+	{
+		T value;
+		std::atomic<uint32_t> seq{Invalid};
+	};
+
+	Slot slots[Capacity];
+	std::atomic<uint32_t> head{0};
+	std::atomic<uint32_t> publishDrops{0};
+	Subscriber subscribers[MaxSubscribers];
+
+	template <typename FUNC>
+	bool read(Subscriber& s, FUNC& fn, TickType_t timeout)
+	{
+		uint32_t cur = s.cursor.load(std::memory_order_relaxed);
+		if (cur == head.load(std::memory_order_acquire))
+		{
+			s.wake.Take(timeout);
+			if (cur == head.load(std::memory_order_acquire))
+				return false;
+		}
+
+		uint32_t available = head.load(std::memory_order_acquire) - cur;
+		if (available > Capacity)
+		{
+			// Overrun: the oldest unread items are gone
+			s.dropped.fetch_add(available - Capacity, std::memory_order_relaxed);
+			cur += available - Capacity;
+		}
+
+		// Pin the sequence, then confirm the producer has not reused the slot
+		Slot& slot = slots[cur % Capacity];
+		s.reading.store(cur);
+		bool valid = slot.seq.load() == cur;
+		if (valid)
+			fn(static_cast<const T&>(slot.value));
+		s.reading.store(Invalid, std::memory_order_release);
+
+		if (valid)
+			s.received.fetch_add(1, std::memory_order_relaxed);
+		else
+			s.dropped.fetch_add(1, std::memory_order_relaxed);
+		s.cursor.store(cur + 1, std::memory_order_relaxed);
+		return valid;
+	}
+};
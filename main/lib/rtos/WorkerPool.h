@@ -0,0 +1,67 @@
+#pragma once
+#include "Queue.h"
+#include "Task.h"
+#include <stdio.h>
+
+/// Fixed set of tasks draining one work queue.
+/// Work items are a function pointer plus argument; the submitter owns
+/// whatever the argument points to until the function has run.
+template<size_t Workers>
+class WorkerPool
+{
+public:
+	struct Work
+	{
+		void (*run)(void*);
+		void* arg;
+	};
+
+	explicit WorkerPool(size_t queueDepth)
+		: queue(queueDepth)
+	{
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	/// Starts `count` of the Workers tasks (all by default).
+	bool Start(const char* name, portBASE_TYPE priority, portSHORT stackDepth,
+		BaseType_t core = tskNO_AFFINITY, size_t count = Workers)
+	{
+		if (started)
+			return true;
+		for (size_t i = 0; i < count && i < Workers; i++)
+		{
+			char taskName[configMAX_TASK_NAME_LEN];
+			snprintf(taskName, sizeof(taskName), "%s%u", name, (unsigned)i);
+			tasks[i].Init(taskName, priority, stackDepth);
+			tasks[i].SetHandler([this]() { work(); });
+			if (!tasks[i].Run(core))
+				return false;
+		}
+		started = true;
+		return true;
+	}
+
+	bool Submit(void (*run)(void*), void* arg, TickType_t timeout = 0)
+	{
+		return queue.Push(Work{run, arg}, timeout);
+	}
+
+	constexpr size_t WorkerCount() const { return Workers; }
+
+private:
+	Queue<Work> queue;
+	Task tasks[Workers];
+	bool started = false;
+
+	void work()
+	{
+		Work item;
+		while (true)
+		{
+			if (queue.Pop(item, portMAX_DELAY))
+				item.run(item.arg);
+		}
+	}
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ContextLock.h"
+#include "EventBus.h"
 #include "IMutex.h"
 #include "Mutex.h"
 #include "Queue.h"
@@ -8,4 +9,5 @@
 #include "Semaphore.h"
 #include "Task.h"
 #include "Timer.h"
+#include "WorkerPool.h"
 
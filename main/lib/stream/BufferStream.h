@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include "Stream.h"
+
+/// Stream over a caller-owned fixed buffer.
+/// Writes past the end are cut off and mark the stream as truncated;
+/// reads return the bytes written so far (or the `used` bytes given up front).
+class BufferStream : public Stream {
+public:
+    BufferStream(void* buffer, size_t capacity, size_t used = 0)
+        : buffer(static_cast<char*>(buffer)), capacity(capacity), used(used) {}
+
+    size_t write(const void* data, size_t len) override {
+        size_t n = len;
+        if (n > capacity - used) {
+            n = capacity - used;
+            truncated = true;
+        }
+        memcpy(buffer + used, data, n);
+        used += n;
+        return n;
+    }
+
+    size_t read(void* out, size_t len) override {
+        size_t n = len < used - readPos ? len : used - readPos;
+        memcpy(out, buffer + readPos, n);
+        readPos += n;
+        return n;
+    }
+
+    void flush() override {}
+
+    const char* Data() const { return buffer; }
+    size_t Size() const { return used; }
+    bool Truncated() const { return truncated; }
+    void Reset() { used = 0; readPos = 0; truncated = false; }
+
+private:
+    char* buffer;
+    size_t capacity;
+    size_t used = 0;
+    size_t readPos = 0;
+    bool truncated = false;
+};
@@ -0,0 +1,122 @@
+"""Packs a web UI build (e.g. firefly-ui's `dist`) into an asset bundle image
+for the `assets` partition, as read by main/Application/Web/file/AssetBundle.h.
+
+Layout, little endian, offsets from the start of the image:
+    Header   magic "FFAB", version, count, image size, build time, checksum
+    Index    one record per stored variant, sorted by URL, then encoding
+    Bodies   stored bytes, each BODY_ALIGN aligned
+
+`x`, `x.gz` and `x.br` are variants of `x`. Text files without a `.gz` get
+one here when that makes them smaller. A plain `x` is left out when a `.gz`
+exists, as the device inflates that for clients without gzip.
+
+Usage: python pack_assets.py <dist dir> <output image> [--max-size BYTES]
+"""
+
+import argparse
+import gzip
+import os
+import struct
+import sys
+import time
+
+MAGIC = b"FFAB"
+VERSION = 2
+MAX_RECORDS = 256
+MAX_URL_LENGTH = 56  # AssetIndex::MaxUrlLength, including the terminator
+BODY_ALIGN = 16
+IDENTITY, GZIP, BROTLI = 0, 1, 2  # ContentEncoding
+EXTENSIONS = {".gz": GZIP, ".br": BROTLI}
+
+HEADER = struct.Struct("<4sHHIII12x")
+RECORD = struct.Struct(f"<{MAX_URL_LENGTH}sIIII")
+
+COMPRESSIBLE = {".html", ".js", ".mjs", ".css", ".json", ".map", ".webmanifest", ".svg", ".txt", ".ttf"}
+
+
+def fnv1a(data: bytes) -> int:
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def collect(dist: str):
+    """Returns {url: {encoding: stored bytes}}."""
+    assets = {}
+    for root, _, files in os.walk(dist):
+        for name in files:
+            path = os.path.join(root, name)
+            rel = os.path.relpath(path, dist).replace(os.sep, "/")
+            stem, ext = os.path.splitext(rel)
+            encoding = EXTENSIONS.get(ext, IDENTITY)
+            url = "/" + (stem if encoding != IDENTITY else rel)
+            with open(path, "rb") as f:
+                assets.setdefault(url, {})[encoding] = f.read()
+
+    for url, variants in assets.items():
+        plain = variants.get(IDENTITY)
+        if plain is not None and GZIP not in variants and os.path.splitext(url)[1].lower() in COMPRESSIBLE:
+            packed = gzip.compress(plain, compresslevel=9, mtime=0)
+            if len(packed) < len(plain):
+                variants[GZIP] = packed
+        if GZIP in variants:
+            variants.pop(IDENTITY, None)
+    return assets
+
+
+def pack(assets, built_at: int) -> bytes:
+    entries = [(url, enc) for url in sorted(assets, key=lambda u: u.encode()) for enc in sorted(assets[url])]
+    if len(entries) > MAX_RECORDS:
+        raise ValueError(f"{len(entries)} stored files, the bundle holds at most {MAX_RECORDS}")
+
+    offset = HEADER.size + RECORD.size * len(entries)
+    records = []
+    bodies = bytearray()
+    for url, encoding in entries:
+        encoded = url.encode()
+        if len(encoded) >= MAX_URL_LENGTH:
+            raise ValueError(f"URL too long for the bundle index: {url}")
+        data = assets[url][encoding]
+        pad = -(offset + len(bodies)) % BODY_ALIGN
+        bodies += b"\0" * pad
+        records.append(RECORD.pack(encoded, offset + len(bodies), len(data), fnv1a(data), encoding))
+        bodies += data
+
+    payload = b"".join(records) + bytes(bodies)
+    image_size = HEADER.size + len(payload)
+    header = HEADER.pack(MAGIC, VERSION, len(entries), image_size, built_at, fnv1a(payload))
+    return header + payload
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Pack a UI build into an asset bundle image.")
+    parser.add_argument("dist", help="directory to pack, e.g. ../firefly-ui/dist")
+    parser.add_argument("output", help="image file to write")
+    parser.add_argument("--max-size", type=lambda v: int(v, 0), help="partition size in bytes")
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.dist):
+        print(f"pack_assets: {args.dist} is not a directory", file=sys.stderr)
+        return 1
+
+    built_at = int(os.environ.get("SOURCE_DATE_EPOCH", time.time()))
+    try:
+        image = pack(collect(args.dist), built_at)
+    except ValueError as e:
+        print(f"pack_assets: {e}", file=sys.stderr)
+        return 1
+    if args.max_size is not None and len(image) > args.max_size:
+        print(f"pack_assets: image is {len(image)} bytes, partition holds {args.max_size}", file=sys.stderr)
+        return 1
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "wb") as f:
+        f.write(image)
+    count = struct.unpack_from("<H", image, 6)[0]
+    print(f"pack_assets: {count} stored files, {len(image)} bytes -> {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())